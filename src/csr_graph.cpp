@@ -0,0 +1,127 @@
+// Graph in compressed sparse row format.
+// Edges are collected with addEdge and laid out by build() in O(V + E)
+// with a counting sort that keeps the insertion order per vertex.
+// The out-edges of u are the indices [offsets[u], offsets[u + 1]) into
+// targets (and weights, if the graph is weighted).
+//
+// CSRGraph<int64_t> g(N);
+// g.addEdge(from, to, w);
+// g.build();
+// for (int e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+//   const int v = g.targets[e];
+//   const int64_t w = g.weights[e];
+// }
+template <class W = int>
+struct CSRGraph {
+  int N;
+  vector<int> offsets;
+  vector<int> targets;
+  // Empty if all edges were added without a weight.
+  vector<W> weights;
+
+  // Edges added since the last build().
+  vector<int> edge_from;
+  vector<int> edge_to;
+  vector<W> edge_weight;
+
+  CSRGraph(int N = 0) : N(N), offsets(N + 1, 0) {}
+
+  // From an adjacency list.
+  CSRGraph(const vector<vector<int>>& g) : N(g.size()), offsets(g.size() + 1, 0) {
+    for (int u = 0; u < N; ++u) {
+      offsets[u + 1] = offsets[u] + g[u].size();
+    }
+    targets.reserve(offsets[N]);
+    for (int u = 0; u < N; ++u) {
+      targets.insert(targets.end(), g[u].begin(), g[u].end());
+    }
+  }
+
+  int addVertex() {
+    offsets.push_back(offsets.back());
+    return N++;
+  }
+
+  void addEdge(int from, int to) {
+    edge_from.push_back(from);
+    edge_to.push_back(to);
+  }
+
+  void addEdge(int from, int to, W w) {
+    addEdge(from, to);
+    edge_weight.push_back(w);
+  }
+
+  int degree(int u) const {
+    return offsets[u + 1] - offsets[u];
+  }
+
+  int numEdges() const {
+    return targets.size();
+  }
+
+  // Merges the edges added since the last build into the CSR arrays.
+  // A graph is either weighted or not: all its edges have a weight, or
+  // none has.
+  void build() {
+    if (edge_from.empty()) return;
+    assert(edge_weight.empty() || edge_weight.size() == edge_from.size());
+    const bool weighted = !edge_weight.empty();
+    assert(targets.empty() || weighted == !weights.empty());
+    vector<int> new_offsets(N + 1, 0);
+    for (int u = 0; u < N; ++u) {
+      new_offsets[u + 1] = offsets[u + 1] - offsets[u];
+    }
+    for (int u : edge_from) {
+      ++new_offsets[u + 1];
+    }
+    for (int u = 0; u < N; ++u) {
+      new_offsets[u + 1] += new_offsets[u];
+    }
+
+    vector<int> new_targets(new_offsets[N]);
+    vector<W> new_weights(weighted ? new_offsets[N] : 0);
+    // Next free position per vertex: old edges first, then new ones.
+    vector<int> position(new_offsets.begin(), new_offsets.end() - 1);
+    for (int u = 0; u < N; ++u) {
+      for (int e = offsets[u]; e < offsets[u + 1]; ++e) {
+        if (weighted) new_weights[position[u]] = weights[e];
+        new_targets[position[u]++] = targets[e];
+      }
+    }
+    for (int i = 0; i < (int) edge_from.size(); ++i) {
+      const int u = edge_from[i];
+      if (weighted) new_weights[position[u]] = edge_weight[i];
+      new_targets[position[u]++] = edge_to[i];
+    }
+
+    offsets.swap(new_offsets);
+    targets.swap(new_targets);
+    weights.swap(new_weights);
+    edge_from.clear();
+    edge_to.clear();
+    edge_weight.clear();
+  }
+
+  // Graph with every edge reversed, built directly from the CSR arrays.
+  CSRGraph reversed() const {
+    CSRGraph r(N);
+    for (int v : targets) {
+      ++r.offsets[v + 1];
+    }
+    for (int u = 0; u < N; ++u) {
+      r.offsets[u + 1] += r.offsets[u];
+    }
+    r.targets.resize(targets.size());
+    r.weights.resize(weights.size());
+    vector<int> position(r.offsets.begin(), r.offsets.end() - 1);
+    for (int u = 0; u < N; ++u) {
+      for (int e = offsets[u]; e < offsets[u + 1]; ++e) {
+        const int p = position[targets[e]]++;
+        r.targets[p] = u;
+        if (!weights.empty()) r.weights[p] = weights[e];
+      }
+    }
+    return r;
+  }
+};
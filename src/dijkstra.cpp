@@ -1,60 +1,380 @@
-struct Dijkstra {
+// Priority queues for Dijkstra. They all have the same interface:
+// push(key, v), pop() -> { key, v }, empty() and clear().
+// pop() can return outdated entries unless the queue has decrease-key,
+// so the caller skips entries whose key doesn't match the distance.
 
-  struct Edge {
-    int to;
-    int64_t w;
-  };
+// std::priority_queue with lazy deletion. Holds up to E entries.
+struct BinaryHeap {
+  priority_queue<pair<int64_t, int>, vector<pair<int64_t, int>>, greater<pair<int64_t, int>>> pq;
+
+  void reserve(int) {}
+
+  bool empty() const {
+    return pq.empty();
+  }
+
+  void push(int64_t key, int v) {
+    pq.push({ key, v });
+  }
+
+  pair<int64_t, int> pop() {
+    const pair<int64_t, int> top = pq.top();
+    pq.pop();
+    return top;
+  }
+
+  void clear() {
+    pq = {};
+  }
+};
+
+// Indexed 4-ary min-heap with decrease-key. Holds at most one entry per
+// vertex, so its size is bounded by V and it never returns outdated
+// entries. A 4-ary heap is shallower than a binary one and its children
+// share a cache line.
+struct DaryHeap {
+  static const int D = 4;
+
+  vector<pair<int64_t, int>> heap;  // { key, vertex }
+  vector<int> position;  // Index of a vertex in heap, -1 if not in it.
+
+  void reserve(int N) {
+    if ((int) position.size() < N) position.resize(N, -1);
+  }
+
+  bool empty() const {
+    return heap.empty();
+  }
+
+  const pair<int64_t, int>& top() const {
+    return heap[0];
+  }
+
+  // Push v, or decrease its key if it is already in the heap.
+  void push(int64_t key, int v) {
+    if (position[v] == -1) {
+      position[v] = heap.size();
+      heap.push_back({ key, v });
+    } else {
+      heap[position[v]].first = key;
+    }
+    siftUp(position[v]);
+  }
+
+  pair<int64_t, int> pop() {
+    const pair<int64_t, int> top = heap[0];
+    position[top.second] = -1;
+    const pair<int64_t, int> last = heap.back();
+    heap.pop_back();
+    if (!heap.empty()) {
+      heap[0] = last;
+      siftDown(0);
+    }
+    return top;
+  }
+
+  // O(size), leaves position all -1 for the next use.
+  void clear() {
+    for (const auto& entry : heap) {
+      position[entry.second] = -1;
+    }
+    heap.clear();
+  }
+
+  void place(int i, const pair<int64_t, int>& entry) {
+    heap[i] = entry;
+    position[entry.second] = i;
+  }
+
+  void siftUp(int i) {
+    const pair<int64_t, int> entry = heap[i];
+    while (i > 0) {
+      const int parent = (i - 1) / D;
+      if (heap[parent].first <= entry.first) break;
+      place(i, heap[parent]);
+      i = parent;
+    }
+    place(i, entry);
+  }
+
+  void siftDown(int i) {
+    const pair<int64_t, int> entry = heap[i];
+    const int n = heap.size();
+    while (true) {
+      const int first_child = D * i + 1;
+      if (first_child >= n) break;
+      int best = first_child;
+      for (int c = first_child + 1; c < min(first_child + D, n); ++c) {
+        if (heap[c].first < heap[best].first) best = c;
+      }
+      if (heap[best].first >= entry.first) break;
+      place(i, heap[best]);
+      i = best;
+    }
+    place(i, entry);
+  }
+};
+
+// Radix heap for non-negative integer keys that are popped in
+// non-decreasing order, which is the case in Dijkstra. Entry with key k
+// goes to bucket "highest bit in which k differs from the last popped
+// key", so each entry moves down at most 64 times in total.
+struct RadixHeap {
+  vector<pair<int64_t, int>> buckets[65];
+  int64_t last = 0;
+  int size = 0;
+
+  void reserve(int) {}
+
+  static int bucket(int64_t x) {
+    return x == 0 ? 0 : 64 - __builtin_clzll(x);
+  }
+
+  bool empty() const {
+    return size == 0;
+  }
 
-  struct Vertex {
-    int v; // Vertex index.
-    int64_t d; // Current shortest path estimate from source to vertex.
-    bool done; // Whether we've already computed this vertex's shortest path.
+  void push(int64_t key, int v) {
+    buckets[bucket(key ^ last)].push_back({ key, v });
+    ++size;
+  }
 
-    bool operator <(const Vertex& v) const {
-      return d > v.d;
+  pair<int64_t, int> pop() {
+    if (buckets[0].empty()) {
+      // Redistribute the first non-empty bucket around its minimum.
+      int i = 1;
+      while (buckets[i].empty()) ++i;
+      last = min_element(buckets[i].begin(), buckets[i].end())->first;
+      for (const auto& entry : buckets[i]) {
+        buckets[bucket(entry.first ^ last)].push_back(entry);
+      }
+      buckets[i].clear();
     }
+    --size;
+    const pair<int64_t, int> top = buckets[0].back();
+    buckets[0].pop_back();
+    return top;
+  }
+
+  void clear() {
+    for (auto& b : buckets) b.clear();
+    last = 0;
+    size = 0;
+  }
+};
+
+// Requires CSRGraph (csr_graph.cpp).
+struct Dijkstra {
+  const int64_t INFTY = numeric_limits<int64_t>::max();
+
+  enum Queue { BINARY_HEAP, DARY_HEAP, RADIX_HEAP };
+
+  // Buffers reused across searches, so repeated queries don't allocate.
+  // Only the vertices touched by the previous search are reset, so an
+  // early exit search costs O(touched) instead of O(V).
+  struct Workspace {
+    vector<int64_t> dist;
+    // Previous vertex on a shortest path, -1 for sources and unreached vertices.
+    vector<int> parent;
+    // Vertices whose dist is not INFTY.
+    vector<int> touched;
+    BinaryHeap binary_heap;
+    DaryHeap dary_heap;
+    RadixHeap radix_heap;
   };
 
-  vector<vector<Edge>> graph;
+  CSRGraph<int64_t> graph;
+  // Only built for bidirectional searches.
+  CSRGraph<int64_t> reverse_graph;
+  Workspace workspace;
+  Workspace reverse_workspace;
 
   Dijkstra(int num_vertices) : graph(num_vertices) {}
 
+  Dijkstra(CSRGraph<int64_t> g) : graph(move(g)) {
+    graph.build();
+    assert(graph.weights.size() == graph.targets.size());
+  }
+
   void addEdge(int from, int to, int64_t w) {
-    graph[from].push_back({ to, w });
+    graph.addEdge(from, to, w);
   }
 
-  vector<int64_t> solve(int start) {
-    // Init.
-    vector<Vertex> vertices(graph.size());
-    for (int i = 0; i < graph.size(); ++i) {
-      vertices[i] = { i, numeric_limits<int64_t>::max(), false };
+  void reset(Workspace& ws) const {
+    if ((int) ws.dist.size() != graph.N) {
+      ws.dist.assign(graph.N, INFTY);
+      ws.parent.assign(graph.N, -1);
+      ws.touched.clear();
+      return;
+    }
+    for (int v : ws.touched) {
+      ws.dist[v] = INFTY;
+      ws.parent[v] = -1;
     }
-    vertices[start].d = 0;
+    ws.touched.clear();
+  }
 
-    priority_queue<Vertex> pq;
-    pq.push({ start, 0, false });
+  // Returns whether the distance of v improved.
+  bool relax(Workspace& ws, int v, int64_t d, int from) const {
+    if (d >= ws.dist[v]) return false;
+    if (ws.dist[v] == INFTY) ws.touched.push_back(v);
+    ws.dist[v] = d;
+    ws.parent[v] = from;
+    return true;
+  }
+
+  // Search from all sources at once, stops as soon as target is done
+  // (target = -1: never). ws must have been reset.
+  template <class PriorityQueue>
+  void run(const vector<int>& sources, int target, Workspace& ws, PriorityQueue& pq) const {
+    pq.reserve(graph.N);
+    for (int s : sources) {
+      if (relax(ws, s, 0, -1)) pq.push(0, s);
+    }
     while (!pq.empty()) {
-      Vertex front = pq.top(); pq.pop();
-      int u = front.v;
-      if (vertices[u].done) continue;
-      for (int i = 0; i < graph[u].size(); ++i) {
-        Edge e = graph[u][i];
-        int from = u;
-        int to = e.to;
-        int64_t w = e.w;
-        if (vertices[from].d + w < vertices[to].d) {
-          vertices[to].d = vertices[from].d + w;
-          pq.push({ to, vertices[to].d, false });
-        }
+      const pair<int64_t, int> front = pq.pop();
+      const int u = front.second;
+      // Outdated entry: u was already done with a shorter distance.
+      if (front.first != ws.dist[u]) continue;
+      if (u == target) break;
+      for (int e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+        const int to = graph.targets[e];
+        const int64_t d = ws.dist[u] + graph.weights[e];
+        if (relax(ws, to, d, u)) pq.push(d, to);
       }
-      vertices[u].done = true;
     }
-    vector<int64_t> dist;
-    dist.reserve(vertices.size());
-    for (const auto& vertex : vertices) {
-      dist.push_back(vertex.d);
+    pq.clear();
+  }
+
+  void run(const vector<int>& sources, int target, Workspace& ws, Queue queue) const {
+    reset(ws);
+    if (queue == BINARY_HEAP) {
+      run(sources, target, ws, ws.binary_heap);
+    } else if (queue == DARY_HEAP) {
+      run(sources, target, ws, ws.dary_heap);
+    } else {
+      run(sources, target, ws, ws.radix_heap);
     }
-    return dist;
   }
 
+  // Distance from the closest source, INFTY if unreachable. The returned
+  // vector is reused by the next call, copy it to keep it.
+  // RADIX_HEAP requires non-negative integer weights (as Dijkstra does).
+  const vector<int64_t>& solve(const vector<int>& sources, Queue queue = DARY_HEAP) {
+    graph.build();
+    run(sources, -1, workspace, queue);
+    return workspace.dist;
+  }
+
+  const vector<int64_t>& solve(int start, Queue queue = DARY_HEAP) {
+    return solve(vector<int>{ start }, queue);
+  }
+
+  // Distances from each source, computed in parallel on num_threads
+  // threads (0: one per core). matrix[i * V + v] is the distance from
+  // sources[i] to v; it is resized to S * V. Each source's row is
+  // contiguous, so threads write to disjoint ranges. Threads take the
+  // next source from a shared counter, so uneven searches balance out,
+  // and each thread reuses its own Workspace.
+  // Compile with -pthread.
+  void solveBatch(const vector<int>& sources, int num_threads, vector<int64_t>& matrix,
+                  Queue queue = DARY_HEAP) {
+    graph.build();
+    const int S = sources.size();
+    const int V = graph.N;
+    matrix.resize((size_t) S * V);
+    if (num_threads <= 0) num_threads = max(1u, thread::hardware_concurrency());
+    num_threads = max(1, min(num_threads, S));
+
+    atomic<int> next_source(0);
+    auto worker = [&](Workspace& ws) {
+      vector<int> source(1);
+      for (int i; (i = next_source.fetch_add(1, memory_order_relaxed)) < S;) {
+        source[0] = sources[i];
+        run(source, -1, ws, queue);
+        copy(ws.dist.begin(), ws.dist.end(), matrix.begin() + (size_t) i * V);
+      }
+    };
+    // The calling thread works too, using the shared workspace.
+    vector<Workspace> workspaces(num_threads - 1);
+    vector<thread> threads;
+    for (int t = 0; t < num_threads - 1; ++t) {
+      threads.emplace_back(worker, ref(workspaces[t]));
+    }
+    worker(workspace);
+    for (thread& t : threads) t.join();
+  }
+
+  // Point to point: stops as soon as t is done.
+  int64_t distance(int s, int t, Queue queue = DARY_HEAP) {
+    graph.build();
+    run({ s }, t, workspace, queue);
+    return workspace.dist[t];
+  }
+
+  // Shortest path from a source to t found by the last solve or distance
+  // call. Empty if t is unreachable.
+  vector<int> path(int t) const {
+    vector<int> result;
+    if (workspace.dist[t] == INFTY) return result;
+    for (int v = t; v != -1; v = workspace.parent[v]) {
+      result.push_back(v);
+    }
+    reverse(result.begin(), result.end());
+    return result;
+  }
+
+  // Point to point, searching forward from s and backward from t at the
+  // same time, always expanding the side with the smaller key. Stops once
+  // the two smallest keys add up to at least the best s-t path seen.
+  // If path is given, it receives the shortest path from s to t.
+  int64_t bidirectionalDistance(int s, int t, vector<int>* path = nullptr) {
+    graph.build();
+    if (reverse_graph.N != graph.N || reverse_graph.numEdges() != graph.numEdges()) {
+      reverse_graph = graph.reversed();
+    }
+    Workspace* ws[2] = { &workspace, &reverse_workspace };
+    const CSRGraph<int64_t>* g[2] = { &graph, &reverse_graph };
+    reset(*ws[0]);
+    reset(*ws[1]);
+    ws[0]->dary_heap.reserve(graph.N);
+    ws[1]->dary_heap.reserve(graph.N);
+    relax(*ws[0], s, 0, -1);
+    relax(*ws[1], t, 0, -1);
+    ws[0]->dary_heap.push(0, s);
+    ws[1]->dary_heap.push(0, t);
+
+    int64_t best = (s == t) ? 0 : INFTY;
+    int meet = (s == t) ? s : -1;
+    while (!ws[0]->dary_heap.empty() && !ws[1]->dary_heap.empty()) {
+      const int64_t top_forward = ws[0]->dary_heap.top().first;
+      const int64_t top_backward = ws[1]->dary_heap.top().first;
+      if (best != INFTY && top_forward + top_backward >= best) break;
+      const int side = (top_forward <= top_backward) ? 0 : 1;
+      Workspace& here = *ws[side];
+      const Workspace& other = *ws[side ^ 1];
+      const int u = here.dary_heap.pop().second;
+      for (int e = g[side]->offsets[u]; e < g[side]->offsets[u + 1]; ++e) {
+        const int to = g[side]->targets[e];
+        const int64_t d = here.dist[u] + g[side]->weights[e];
+        if (relax(here, to, d, u)) here.dary_heap.push(d, to);
+        if (other.dist[to] != INFTY && d + other.dist[to] < best) {
+          best = d + other.dist[to];
+          meet = to;
+        }
+      }
+    }
+    ws[0]->dary_heap.clear();
+    ws[1]->dary_heap.clear();
+
+    if (path != nullptr) {
+      path->clear();
+      if (meet != -1) {
+        for (int v = meet; v != -1; v = ws[0]->parent[v]) path->push_back(v);
+        reverse(path->begin(), path->end());
+        for (int v = ws[1]->parent[meet]; v != -1; v = ws[1]->parent[v]) path->push_back(v);
+      }
+    }
+    return best;
+  }
 };
@@ -0,0 +1,111 @@
+// Fenwick tree (Binary Indexed Tree).
+// Point add, prefix/range sums. Drop-in for the sum SegTree when only
+// sums are needed: half the memory and no recursion.
+// Build: O(N)
+// add, prefixSum, rangeSum, lowerBound: O(log N)
+template <class T>
+struct FenwickTree {
+  int N;
+  vector<T> tree;  // 1-indexed, tree[i] is the sum of (i - lowbit(i), i].
+
+  FenwickTree(int N) : N(N), tree(N + 1, 0) {}
+
+  FenwickTree(const vector<T>& elements) : N(elements.size()), tree(N + 1, 0) {
+    // Every node passes its sum on to its parent once.
+    for (int i = 1; i <= N; ++i) {
+      tree[i] += elements[i - 1];
+      const int parent = i + (i & -i);
+      if (parent <= N) tree[parent] += tree[i];
+    }
+  }
+
+  void add(int index, T value) {
+    for (++index; index <= N; index += index & -index) {
+      tree[index] += value;
+    }
+  }
+
+  // Sum of [0, index]. Returns 0 if index < 0.
+  T prefixSum(int index) const {
+    T sum = 0;
+    for (++index; index > 0; index -= index & -index) {
+      sum += tree[index];
+    }
+    return sum;
+  }
+
+  // Inclusive range [left, right].
+  T rangeSum(int left, int right) const {
+    return prefixSum(right) - prefixSum(left - 1);
+  }
+
+  T get(int index) const {
+    return rangeSum(index, index);
+  }
+
+  void pointSet(int index, T value) {
+    add(index, value - get(index));
+  }
+
+  // Smallest index such that prefixSum(index) >= value, or N if there
+  // is none. Requires all elements to be non-negative.
+  // Binary lifting: walks down the implicit tree in one O(log N) pass.
+  int lowerBound(T value) const {
+    int pos = 0;
+    int step = 1;
+    while (2 * step <= N) step *= 2;
+    for (; step > 0; step /= 2) {
+      if (pos + step <= N && tree[pos + step] < value) {
+        pos += step;
+        value -= tree[pos];
+      }
+    }
+    return pos;
+  }
+};
+
+// Range add and range sum with two Fenwick trees over the difference
+// array d[i] = a[i] - a[i - 1]:
+// prefixSum(i) = (i + 1) * sum(d[0..i]) - sum(j * d[j] for j in [0, i]).
+// Build: O(N)
+// rangeAdd, rangeSum: O(log N)
+template <class T>
+struct RangeFenwickTree {
+  int N;
+  FenwickTree<T> diff;
+  FenwickTree<T> weighted_diff;
+
+  RangeFenwickTree(int N) : N(N), diff(N), weighted_diff(N) {}
+
+  RangeFenwickTree(const vector<T>& elements) :
+    N(elements.size()), diff(differences(elements, false)), weighted_diff(differences(elements, true)) {}
+
+  static vector<T> differences(const vector<T>& elements, bool weighted) {
+    vector<T> d(elements.size());
+    for (int i = 0; i < (int) elements.size(); ++i) {
+      d[i] = elements[i] - (i > 0 ? elements[i - 1] : T(0));
+      if (weighted) d[i] *= i;
+    }
+    return d;
+  }
+
+  // Add value to every element in [left, right].
+  void rangeAdd(int left, int right, T value) {
+    diff.add(left, value);
+    weighted_diff.add(left, value * left);
+    if (right + 1 < N) {
+      diff.add(right + 1, -value);
+      weighted_diff.add(right + 1, -value * (right + 1));
+    }
+  }
+
+  // Sum of [0, index]. Returns 0 if index < 0.
+  T prefixSum(int index) const {
+    return diff.prefixSum(index) * (index + 1) - weighted_diff.prefixSum(index);
+  }
+
+  // Inclusive range [left, right].
+  T rangeSum(int left, int right) const {
+    return prefixSum(right) - prefixSum(left - 1);
+  }
+};
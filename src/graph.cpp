@@ -1,57 +1,89 @@
+// Requires VertexState (vertex_state.cpp).
+
 // If graph is not connected, call this function
 // for every vertex, i.e.
 // for (int i = 0; i < N; ++i) dfsFindCycles(i, ...);
 // Find cycles in undirected graph
 // If graph is directed, then remove the line with the NOTE below.
-void dfsFindCycles(int u, const vector<vector<int>>& g,
-                   vector<string>& color,
+void dfsFindCycles(int start, const vector<vector<int>>& g,
+                   VertexState& color,
                    vector<int>& parent,
                    vector<vector<int>>& cycles) {
-  if (color[u] == "BLACK") {
-    return;
-  } else if (color[u] == "WHITE") {
-    color[u] = "GREY";
-    for (int neighbor : g[u]) {
+  // Returns whether u has to be expanded.
+  auto visit = [&](int u) -> bool {
+    if (color.get(u) == VertexState::BLACK) {
+      return false;
+    } else if (color.get(u) == VertexState::WHITE) {
+      color.set(u, VertexState::GREY);
+      return true;
+    } else if (color.get(u) == VertexState::GREY) {
+      // Cycle detected.
+      cycles.push_back({});
+      int v = parent[u];
+      while (v != u) {
+        cycles.back().push_back(v);
+        v = parent[v];
+      }
+      cycles.back().push_back(v);
+      return false;
+    } else {
+      assert(false);
+    }
+  };
+
+  if (!visit(start)) return;
+  // Explicit stack of { vertex, next neighbor index } instead of recursion.
+  vector<pair<int, int>> stack = { { start, 0 } };
+  while (!stack.empty()) {
+    const int u = stack.back().first;
+    int& i = stack.back().second;
+    if (i < (int) g[u].size()) {
+      const int neighbor = g[u][i++];
       if (parent[u] == neighbor) continue;  // NOTE: If the graph is directed, then remove this line.
       parent[neighbor] = u;
-      dfsFindCycles(neighbor, g, color, parent, cycles);
-    }
-    color[u] = "BLACK";
-  } else if (color[u] == "GREY") {
-    // Cycle detected.
-    cycles.push_back({});
-    int v = parent[u];
-    while (v != u) {
-      cycles.back().push_back(v);
-      v = parent[v];
+      if (visit(neighbor)) {
+        stack.push_back({ neighbor, 0 });
+      }
+    } else {
+      color.set(u, VertexState::BLACK);
+      stack.pop_back();
     }
-    cycles.back().push_back(v);
-  } else {
-    assert(false);
   }
 }
 
 // ------------------------------
-bool hasCycleDFS(int u, const vector<vector<int>>& g,
-                 vector<string>& color) {
-  if (color[u] == "BLACK") {
-    return false;
-  } else if (color[u] == "WHITE") {
-    color[u] = "GREY";
-    for (int neighbor : g[u]) {
-      if (hasCycleDFS(neighbor, g, color)) return true;
-    }
-    color[u] = "BLACK";
+bool hasCycleDFS(int start, const vector<vector<int>>& g,
+                 VertexState& color) {
+  if (color.get(start) == VertexState::BLACK) {
     return false;
-  } else if (color[u] == "GREY") {
-    // Cycle detected.
+  } else if (color.get(start) == VertexState::GREY) {
     return true;
-  } else {
-    assert(false);
   }
+  color.set(start, VertexState::GREY);
+  // Explicit stack of { vertex, next neighbor index } instead of recursion.
+  vector<pair<int, int>> stack = { { start, 0 } };
+  while (!stack.empty()) {
+    const int u = stack.back().first;
+    int& i = stack.back().second;
+    if (i < (int) g[u].size()) {
+      const int neighbor = g[u][i++];
+      if (color.get(neighbor) == VertexState::GREY) {
+        // Cycle detected.
+        return true;
+      } else if (color.get(neighbor) == VertexState::WHITE) {
+        color.set(neighbor, VertexState::GREY);
+        stack.push_back({ neighbor, 0 });
+      }
+    } else {
+      color.set(u, VertexState::BLACK);
+      stack.pop_back();
+    }
+  }
+  return false;
 }
 
-vector<string> color(N, "WHITE");
+// For repeated checks, color.reset() makes all vertices WHITE in O(1).
+VertexState color(N);
 bool has_cycle = false;
 for (int i = 0; i < N; ++i) {
   has_cycle |= hasCycleDFS(i, graph, color);
@@ -59,22 +91,34 @@ for (int i = 0; i < N; ++i) {
 
 // ------------------------------
 
-void findTopologicalOrder(int u, const vector<vector<int>>& g, vector<bool>& visited, vector<int>& order) {
-  if (visited[u]) {
+void findTopologicalOrder(int start, const vector<vector<int>>& g, VertexState& visited, vector<int>& order) {
+  if (visited.visited(start)) {
     return;
   }
 
-  visited[u] = true;
-  for (int v : g[u]) {
-    findTopologicalOrder(v, g, visited, order);    
+  visited.set(start, VertexState::BLACK);
+  // Explicit stack of { vertex, next neighbor index } instead of recursion.
+  vector<pair<int, int>> stack = { { start, 0 } };
+  while (!stack.empty()) {
+    const int u = stack.back().first;
+    int& i = stack.back().second;
+    if (i < (int) g[u].size()) {
+      const int v = g[u][i++];
+      if (!visited.visited(v)) {
+        visited.set(v, VertexState::BLACK);
+        stack.push_back({ v, 0 });
+      }
+    } else {
+      order.push_back(u);
+      stack.pop_back();
+    }
   }
-  order.push_back(u);
 }
 
 vector<int> order;
-vector<bool> visited(N, false);
+VertexState visited(N);
 for (int i = 0; i < N; ++i) {
-  if (!visited[i]) {
+  if (!visited.visited(i)) {
     findTopologicalOrder(i, graph, visited, order);
   }
 }
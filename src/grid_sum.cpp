@@ -1,49 +1,195 @@
+// Static 2D range sums.
+// Build: O(R * C)
+// Query: O(1), four loads and no branches.
 template <typename T>
 class GridSum {
 private:
   int R_;
   int C_;
-  vector<vector<T>> grid_;
-  // Indexed w.r.t. bottom right corner of rectangle.
-  vector<vector<T>> prefix_sums_;
+  // Flat (R_ + 1) x (C_ + 1) row-major table, zero-padded in row 0 and
+  // column 0: prefix_sums_[(r + 1, c + 1)] is the sum of [0, r] x [0, c].
+  vector<T> prefix_sums_;
 
-  bool withinBounds(const pair<int, int>& p) const {
-    int row = p.first;
-    int col = p.second;
-    return (row >= 0 && row < R_ && col >= 0 && col < C_);
+  int index(int r, int c) const {
+    return r * (C_ + 1) + c;
   }
 
+  // Expects the cell values at index(r + 1, c + 1) and zeros in the padding.
   void computePrefixSums() {
-    prefix_sums_ = vector<vector<T>>(R_, vector<T>(C_));
-    for (int r = 0; r < R_; ++r) {
-      for (int c = 0; c < C_; ++c) {
-        pair<int, int> left = { r, c - 1 };
-        pair<int, int> up = { r - 1, c };
-        pair<int, int> up_left = { r - 1, c - 1 };
-        T sum = grid_[r][c];
-        if (withinBounds(left)) sum += prefix_sums_[left.first][left.second];
-        if (withinBounds(up)) sum += prefix_sums_[up.first][up.second];
-        if (withinBounds(up_left)) sum -= prefix_sums_[up_left.first][up_left.second];
-        prefix_sums_[r][c] = sum;
+    for (int r = 1; r <= R_; ++r) {
+      for (int c = 1; c <= C_; ++c) {
+        prefix_sums_[index(r, c)] += prefix_sums_[index(r, c - 1)] +
+                                     prefix_sums_[index(r - 1, c)] -
+                                     prefix_sums_[index(r - 1, c - 1)];
       }
     }
   }
 
 public:
-  GridSum(const vector<vector<T>>& grid) : grid_(grid) {
-    R_ = grid.size();
-    C_ = grid[0].size();
+  struct Rectangle {
+    int row1;
+    int row2;
+    int col1;
+    int col2;
+  };
+
+  GridSum(const vector<vector<T>>& grid) : R_(grid.size()), C_(grid[0].size()) {
+    prefix_sums_.assign((R_ + 1) * (C_ + 1), 0);
+    for (int r = 0; r < R_; ++r) {
+      copy(grid[r].begin(), grid[r].end(), prefix_sums_.begin() + index(r + 1, 1));
+    }
+    computePrefixSums();
+  }
+
+  // Builds in place from a row-major R x C buffer, without a second copy
+  // of the grid. Reserve (R + 1) * (C + 1) in cells to avoid reallocation.
+  GridSum(int R, int C, vector<T>&& cells) : R_(R), C_(C), prefix_sums_(move(cells)) {
+    prefix_sums_.resize((R_ + 1) * (C_ + 1));
+    // Shift every cell to its padded position. Cells only move towards
+    // the back, so going backwards never overwrites an unmoved cell.
+    for (int r = R_ - 1; r >= 0; --r) {
+      for (int c = C_ - 1; c >= 0; --c) {
+        prefix_sums_[index(r + 1, c + 1)] = prefix_sums_[r * C_ + c];
+      }
+      prefix_sums_[index(r + 1, 0)] = 0;
+    }
+    fill(prefix_sums_.begin(), prefix_sums_.begin() + C_ + 1, 0);
     computePrefixSums();
   }
 
   T sum(int row1, int row2, int col1, int col2) const {
-    T S = prefix_sums_[row2][col2];
-    pair<int, int> left = { row2, col1 - 1 };
-    pair<int, int> up = { row1 - 1, col2 };
-    pair<int, int> up_left = { row1 - 1, col1 - 1 };
-    if (withinBounds(left)) S -= prefix_sums_[left.first][left.second];
-    if (withinBounds(up)) S -= prefix_sums_[up.first][up.second];
-    if (withinBounds(up_left)) S += prefix_sums_[up_left.first][up_left.second];
+    return prefix_sums_[index(row2 + 1, col2 + 1)] - prefix_sums_[index(row1, col2 + 1)] -
+           prefix_sums_[index(row2 + 1, col1)] + prefix_sums_[index(row1, col1)];
+  }
+
+  // Batch query, sums[i] is the sum of rectangles[i].
+  void sum(const vector<Rectangle>& rectangles, vector<T>& sums) const {
+    sums.resize(rectangles.size());
+    for (int i = 0; i < (int) rectangles.size(); ++i) {
+      const Rectangle& q = rectangles[i];
+      sums[i] = sum(q.row1, q.row2, q.col1, q.col2);
+    }
+  }
+};
+
+// Updatable GridSum: 2D Fenwick tree stored in one flat array.
+// Build: O(R * C)
+// add, set, sum: O(log R * log C)
+template <typename T>
+class DynamicGridSum {
+private:
+  int R_;
+  int C_;
+  // 1-indexed (R_ + 1) x (C_ + 1) Fenwick tree, row-major.
+  vector<T> tree_;
+
+  T& at(int r, int c) {
+    return tree_[r * (C_ + 1) + c];
+  }
+
+  T at(int r, int c) const {
+    return tree_[r * (C_ + 1) + c];
+  }
+
+public:
+  DynamicGridSum(int R, int C) : R_(R), C_(C), tree_((R + 1) * (C + 1), 0) {}
+
+  DynamicGridSum(const vector<vector<T>>& grid) : DynamicGridSum(grid.size(), grid[0].size()) {
+    for (int r = 1; r <= R_; ++r) {
+      for (int c = 1; c <= C_; ++c) {
+        at(r, c) += grid[r - 1][c - 1];
+      }
+    }
+    // Every node passes its sum on to its parent, first along the rows,
+    // then along the columns.
+    for (int r = 1; r <= R_; ++r) {
+      for (int c = 1; c <= C_; ++c) {
+        const int parent = c + (c & -c);
+        if (parent <= C_) at(r, parent) += at(r, c);
+      }
+    }
+    for (int r = 1; r <= R_; ++r) {
+      const int parent = r + (r & -r);
+      if (parent > R_) continue;
+      for (int c = 1; c <= C_; ++c) {
+        at(parent, c) += at(r, c);
+      }
+    }
+  }
+
+  void add(int row, int col, T delta) {
+    for (int r = row + 1; r <= R_; r += r & -r) {
+      for (int c = col + 1; c <= C_; c += c & -c) {
+        at(r, c) += delta;
+      }
+    }
+  }
+
+  void set(int row, int col, T value) {
+    add(row, col, value - sum(row, row, col, col));
+  }
+
+  // Sum of the rectangle [0, row] x [0, col]. Returns 0 if row or col < 0.
+  T prefixSum(int row, int col) const {
+    T S = 0;
+    for (int r = row + 1; r > 0; r -= r & -r) {
+      for (int c = col + 1; c > 0; c -= c & -c) {
+        S += at(r, c);
+      }
+    }
     return S;
   }
+
+  T sum(int row1, int row2, int col1, int col2) const {
+    return prefixSum(row2, col2) - prefixSum(row1 - 1, col2) -
+           prefixSum(row2, col1 - 1) + prefixSum(row1 - 1, col1 - 1);
+  }
+};
+
+// GridSum with rectangle add, using four 2D Fenwick trees over the 2D
+// difference array d. With d summed over [0, r] x [0, c]:
+// prefixSum(r, c) = (r + 1)(c + 1) sum(d) - (c + 1) sum(d * i)
+//                   - (r + 1) sum(d * j) + sum(d * i * j)
+// rangeAdd, sum: O(log R * log C)
+template <typename T>
+class RangeGridSum {
+private:
+  int R_;
+  int C_;
+  DynamicGridSum<T> d_;
+  DynamicGridSum<T> di_;
+  DynamicGridSum<T> dj_;
+  DynamicGridSum<T> dij_;
+
+  void pointAdd(int row, int col, T delta) {
+    if (row >= R_ || col >= C_) return;
+    d_.add(row, col, delta);
+    di_.add(row, col, delta * row);
+    dj_.add(row, col, delta * col);
+    dij_.add(row, col, delta * row * col);
+  }
+
+  T prefixSum(int row, int col) const {
+    if (row < 0 || col < 0) return 0;
+    return d_.prefixSum(row, col) * (row + 1) * (col + 1) -
+           di_.prefixSum(row, col) * (col + 1) -
+           dj_.prefixSum(row, col) * (row + 1) +
+           dij_.prefixSum(row, col);
+  }
+
+public:
+  RangeGridSum(int R, int C) : R_(R), C_(C), d_(R, C), di_(R, C), dj_(R, C), dij_(R, C) {}
+
+  // Add delta to every cell in [row1, row2] x [col1, col2].
+  void rangeAdd(int row1, int row2, int col1, int col2, T delta) {
+    pointAdd(row1, col1, delta);
+    pointAdd(row1, col2 + 1, -delta);
+    pointAdd(row2 + 1, col1, -delta);
+    pointAdd(row2 + 1, col2 + 1, delta);
+  }
+
+  T sum(int row1, int row2, int col1, int col2) const {
+    return prefixSum(row2, col2) - prefixSum(row1 - 1, col2) -
+           prefixSum(row2, col1 - 1) + prefixSum(row1 - 1, col1 - 1);
+  }
 };
@@ -1,49 +1,132 @@
+// Hopcroft-Karp maximum bipartite matching: each phase layers the left
+// vertices with a BFS and augments along the layers with DFSs.
+// The first sqrt(V) phases keep all the layers, which finds more paths
+// per phase in practice. Later phases stop at the shortest augmenting
+// paths as in Hopcroft-Karp, which needs O(sqrt(V)) phases from any
+// starting matching. O(E sqrt(V)).
+// Requires CSRGraph (csr_graph.cpp).
 class Matching {
  public:
   int _m;
   int _n;
-  vector<vector<int>> _graph;
+  CSRGraph<> _graph;
   vector<int> _ma;
   vector<int> _mb;
-  vector<bool> _visited;
   int _flow;
 
-  Matching(int m, int n) : _m(m), _n(n) {
-    _graph.resize(m);
+  // Scratch reused across phases.
+  vector<int> _dist;  // BFS layer of each left vertex, -1 if not in the layers.
+  vector<int> _it;  // Current arc: next edge to try per left vertex.
+  vector<int> _queue;
+  vector<int> _stack;
+
+  Matching(int m, int n) : Matching(m, n, CSRGraph<>(m)) {}
+
+  // graph has an edge from left vertex i to right vertex j for every pair.
+  Matching(int m, int n, CSRGraph<> graph) : _m(m), _n(n), _graph(move(graph)) {
+    assert(_graph.N == m);
     _ma.assign(m, -1);
     _mb.assign(n, -1);
     _flow = 0;
   }
 
   void add(int i, int j) {
-    _graph[i].push_back(j);
+    _graph.addEdge(i, j);
+  }
+
+  // Warm start: match every left vertex to its first free neighbor.
+  void greedy() {
+    for (int i = 0; i < _m; ++i) {
+      if (_ma[i] != -1) continue;
+      for (int e = _graph.offsets[i]; e < _graph.offsets[i + 1]; ++e) {
+        const int right = _graph.targets[e];
+        if (_mb[right] == -1) {
+          _ma[i] = right;
+          _mb[right] = i;
+          break;
+        }
+      }
+    }
+  }
+
+  // Layers the left vertices by alternating path length from the free
+  // ones. Returns whether some free right vertex is reachable.
+  // shortest_only: stops at the first layer that reaches one.
+  bool bfs(bool shortest_only) {
+    _dist.assign(_m, -1);
+    _queue.clear();
+    for (int i = 0; i < _m; ++i) {
+      if (_ma[i] == -1) {
+        _dist[i] = 0;
+        _queue.push_back(i);
+      }
+    }
+    bool found = false;
+    for (int head = 0; head < (int) _queue.size(); ++head) {
+      const int left = _queue[head];
+      if (shortest_only && found && _dist[left] > _dist[_queue[head - 1]]) {
+        // Deeper than the shortest augmenting paths, out of the layers.
+        for (; head < (int) _queue.size(); ++head) {
+          _dist[_queue[head]] = -1;
+        }
+        break;
+      }
+      for (int e = _graph.offsets[left]; e < _graph.offsets[left + 1]; ++e) {
+        const int next = _mb[_graph.targets[e]];
+        if (next == -1) {
+          found = true;
+        } else if (_dist[next] == -1) {
+          _dist[next] = _dist[left] + 1;
+          _queue.push_back(next);
+        }
+      }
+    }
+    return found;
   }
 
-  bool dfs(int left) {
-    for (int right : _graph[left]) {
-      if (!_visited[right]) {
-        _visited[right] = true;
-        // Try to free up right by matching whatever it's
-        // matched to on the left side (either nothing (-1) or _mb[right])
-        // to something new.
-        if (_mb[right] == -1 || dfs(_mb[right])) {
-          _ma[left] = right;
-          _mb[right] = left;
-          return true;
+  // Iterative DFS from a free left vertex, going one layer deeper at each
+  // step. _stack holds the left vertices of the path, _it[left] the edge
+  // taken from each of them.
+  bool augment(int root) {
+    _stack.assign(1, root);
+    while (!_stack.empty()) {
+      const int left = _stack.back();
+      if (_it[left] == _graph.offsets[left + 1]) {
+        // Dead end: drop it from the layers for this phase.
+        _dist[left] = -1;
+        _stack.pop_back();
+        continue;
+      }
+      const int next = _mb[_graph.targets[_it[left]]];
+      if (next == -1) {
+        // Free right vertex: flip the matching along the path.
+        for (int u : _stack) {
+          const int right = _graph.targets[_it[u]];
+          _ma[u] = right;
+          _mb[right] = u;
         }
+        return true;
+      }
+      if (_dist[next] == _dist[left] + 1) {
+        _stack.push_back(next);
+      } else {
+        ++_it[left];
       }
     }
     return false;
   }
 
   int solve() {
-    for (int i = 0; i < _m; ++i) {
-      _visited.assign(_n, false);
-      if (dfs(i)) {
-        ++_flow;
+    _graph.build();
+    greedy();
+    const int all_layer_phases = sqrt(_m + _n);
+    for (int phase = 0; bfs(phase >= all_layer_phases); ++phase) {
+      _it.assign(_graph.offsets.begin(), _graph.offsets.end() - 1);
+      for (int i = 0; i < _m; ++i) {
+        if (_ma[i] == -1) augment(i);
       }
     }
+    _flow = _m - count(_ma.begin(), _ma.end(), -1);
     return _flow;
   }
-
 };
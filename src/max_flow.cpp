@@ -1,4 +1,8 @@
-// Implementation using adjacency list.
+// Dinic's algorithm: BFS builds the level graph, then a blocking flow is
+// sent along it. O(V^2 E) in general, O(E sqrt(V)) on unit capacity
+// graphs such as bipartite matching.
+// Implementation using adjacency list in CSR format.
+// Requires CSRGraph (csr_graph.cpp).
 template <typename T>
 class MaxFlow {
  public:
@@ -10,7 +14,7 @@ class MaxFlow {
   };
 
   // Residual graph in adjacency list format. Contains indices into edges vector.
-  vector<vector<T>> g_;
+  CSRGraph<> g_;
   vector<Edge> edges_;
   int source_;
   int sink_;
@@ -19,70 +23,285 @@ class MaxFlow {
   MaxFlow(int N, int source, int sink) :
     g_(N), edges_(0), source_(source), sink_(sink), N_(N) {}
 
+  // Weights of g are the capacities.
+  MaxFlow(CSRGraph<T> g, int source, int sink) : MaxFlow(g.N, source, sink) {
+    g.build();
+    assert(g.weights.size() == g.targets.size());
+    for (int u = 0; u < g.N; ++u) {
+      for (int e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+        addEdge(u, g.targets[e], g.weights[e]);
+      }
+    }
+  }
+
   void addEdge(int from, int to, T cap) {
     if (from != to) {
       edges_.push_back(Edge(from, to, cap));
-      g_[from].push_back(edges_.size() - 1);
+      g_.addEdge(from, edges_.size() - 1);
       // The inverse edge has 0 capacity.
       edges_.push_back(Edge(to, from, 0));
-      g_[to].push_back(edges_.size() - 1);
+      g_.addEdge(to, edges_.size() - 1);
     }
   }
 
-  // Path contains indices to edges.
-  T findAugmentingPath(vector<int>& path) {
-    path.clear();
-    T flow = 0;
-    // BFS.
-    queue<int> q;
-    q.push(source_);
-    vector<bool> visited(N_, false);
-    vector<int> parent(N_); // Edge index that leads to this vertex.
-    while(!q.empty()) {
-      int u = q.front(); q.pop();
-      visited[u] = true;
-      for (int edge_idx : g_[u]) {
-        Edge e = edges_[edge_idx];
-        int v = e.to;
-        if (!visited[v] && e.cap > 0) {
-          q.push(v);
-          parent[v] = edge_idx;
-          if (v == sink_) {
-            // Path found.
-            flow = e.cap;
-            while (v != source_) {
-              path.push_back(edge_idx);
-              flow = min(flow, e.cap);
-              v = e.from;
-              edge_idx = parent[v];
-              e = edges_[edge_idx];
-            }
-            reverse(path.begin(), path.end());
-            return flow;
-          }
+  // Scratch reused across phases.
+  vector<int> level_;  // BFS distance from the source, -1 if unreachable.
+  vector<int> arc_;  // Current arc: next position in g_ to try per vertex.
+  vector<int> queue_;
+  vector<int> path_;  // Edge indices from the source.
+
+  // Moves flow along edge_idx. The regular and reverse edges appear in
+  // pairs of 2, so flipping the last bit gives the other one.
+  void push(int edge_idx, T flow) {
+    edges_[edge_idx].cap -= flow;
+    edges_[edge_idx].flow += flow;
+    edges_[edge_idx ^ 1].cap += flow;
+    edges_[edge_idx ^ 1].flow -= flow;
+  }
+
+  // Returns whether the sink is reachable in the residual graph.
+  bool buildLevels() {
+    level_.assign(N_, -1);
+    queue_.clear();
+    level_[source_] = 0;
+    queue_.push_back(source_);
+    for (int head = 0; head < (int) queue_.size(); ++head) {
+      const int u = queue_[head];
+      for (int k = g_.offsets[u]; k < g_.offsets[u + 1]; ++k) {
+        const Edge& e = edges_[g_.targets[k]];
+        if (e.cap > 0 && level_[e.to] == -1) {
+          level_[e.to] = level_[u] + 1;
+          queue_.push_back(e.to);
+        }
+      }
+    }
+    return level_[sink_] != -1;
+  }
+
+  // Augments along source-sink paths of the level graph until none is
+  // left. Iterative, and arc_ skips the edges that already failed, so
+  // every edge is passed over at most once per phase.
+  T blockingFlow() {
+    for (int u = 0; u < N_; ++u) {
+      arc_[u] = g_.offsets[u];
+    }
+    T total = 0;
+    path_.clear();
+    int u = source_;
+    while (true) {
+      if (u == sink_) {
+        T flow = edges_[path_[0]].cap;
+        for (int edge_idx : path_) {
+          flow = min(flow, edges_[edge_idx].cap);
+        }
+        int saturated = -1;
+        for (int i = 0; i < (int) path_.size(); ++i) {
+          push(path_[i], flow);
+          if (saturated == -1 && edges_[path_[i]].cap == 0) saturated = i;
         }
+        total += flow;
+        // Continue from the tail of the first saturated edge.
+        path_.resize(saturated);
+        u = path_.empty() ? source_ : edges_[path_.back()].to;
+        continue;
+      }
+      int& k = arc_[u];
+      while (k < g_.offsets[u + 1]) {
+        const Edge& e = edges_[g_.targets[k]];
+        if (e.cap > 0 && level_[e.to] == level_[u] + 1) break;
+        ++k;
+      }
+      if (k < g_.offsets[u + 1]) {
+        path_.push_back(g_.targets[k]);
+        u = edges_[path_.back()].to;
+      } else {
+        // Dead end: retreat and don't come back this phase.
+        if (u == source_) break;
+        level_[u] = -1;
+        path_.pop_back();
+        u = path_.empty() ? source_ : edges_[path_.back()].to;
+        ++arc_[u];
       }
     }
-    return 0;
+    return total;
   }
 
   T solve() {
+    g_.build();
+    if (source_ == sink_) return 0;
+    arc_.resize(N_);
     T flow = 0;
-    vector<int> path;
-    while (T path_flow = findAugmentingPath(path)) {
-      flow += path_flow;
-      for (int edge_idx : path) {
-        edges_[edge_idx].cap -= path_flow;
-        edges_[edge_idx].flow += path_flow;
-        // Reverse edges. The regular and reverse edges
-        // appear in pairs of 2. Therefore if we have one
-        // we have to flip the last bit to find the other.
-        edges_[edge_idx ^ 1].cap += path_flow;
-        edges_[edge_idx ^ 1].flow -= path_flow;
-      }
+    while (buildLevels()) {
+      flow += blockingFlow();
     }
     return flow;
   }
+
+  // After solve(): the source side of a minimum cut is the set of vertices
+  // with level_[v] != -1. Returns the indices into edges_ of the edges
+  // crossing it, they are saturated and their flows add up to the max flow.
+  // Empty before solve() and when the source is the sink.
+  vector<int> minCut() const {
+    vector<int> cut;
+    if (level_.empty() || source_ == sink_) return cut;
+    for (int edge_idx = 0; edge_idx < (int) edges_.size(); edge_idx += 2) {
+      const Edge& e = edges_[edge_idx];
+      if (level_[e.from] != -1 && level_[e.to] == -1) cut.push_back(edge_idx);
+    }
+    return cut;
+  }
 };
 
+// Highest-label push-relabel, on the same edges as MaxFlow. Vertices hold
+// excess flow and push it to neighbors one level lower, always
+// discharging the highest active vertex first. Gap heuristic: when no
+// vertex is left at some height below N, the ones above it can't reach
+// the sink and are lifted at once. Global relabel: heights are reset to
+// exact residual distances by a reverse BFS every N relabels.
+// O(V^2 sqrt(E)), usually faster than Dinic on dense graphs.
+template <typename T>
+class PushRelabel : public MaxFlow<T> {
+ public:
+  using typename MaxFlow<T>::Edge;
+  using MaxFlow<T>::MaxFlow;
+  using MaxFlow<T>::g_;
+  using MaxFlow<T>::edges_;
+  using MaxFlow<T>::source_;
+  using MaxFlow<T>::sink_;
+  using MaxFlow<T>::N_;
+  using MaxFlow<T>::arc_;
+  using MaxFlow<T>::queue_;
+
+  vector<int> height_;
+  vector<T> excess_;
+  vector<int> count_;  // Number of vertices per height.
+  vector<vector<int>> active_;  // Vertices with excess, per height.
+  int highest_;  // No active vertex is higher.
+  int relabels_;  // Since the last global relabel.
+
+  void pushExcess(int edge_idx, T flow) {
+    const int to = edges_[edge_idx].to;
+    if (excess_[to] == 0 && to != sink_ && to != source_) activate(to);
+    this->push(edge_idx, flow);
+    excess_[edges_[edge_idx].from] -= flow;
+    excess_[to] += flow;
+  }
+
+  void activate(int v) {
+    if (height_[v] >= 2 * N_) return;
+    active_[height_[v]].push_back(v);
+    highest_ = max(highest_, height_[v]);
+  }
+
+  void setHeight(int v, int h) {
+    --count_[height_[v]];
+    height_[v] = h;
+    ++count_[h];
+    arc_[v] = g_.offsets[v];
+  }
+
+  // Heights from a reverse BFS: distance to the sink, or N + distance to
+  // the source for vertices that can't reach the sink.
+  void globalRelabel() {
+    relabels_ = 0;
+    height_.assign(N_, 2 * N_);
+    queue_.clear();
+    for (int root : { sink_, source_ }) {
+      height_[root] = (root == sink_) ? 0 : N_;
+      queue_.push_back(root);
+      for (int head = queue_.size() - 1; head < (int) queue_.size(); ++head) {
+        const int v = queue_[head];
+        for (int k = g_.offsets[v]; k < g_.offsets[v + 1]; ++k) {
+          const int edge_idx = g_.targets[k];
+          const int w = edges_[edge_idx].to;
+          // edge_idx ^ 1 goes from w to v.
+          if (edges_[edge_idx ^ 1].cap > 0 && height_[w] == 2 * N_) {
+            height_[w] = height_[v] + 1;
+            queue_.push_back(w);
+          }
+        }
+      }
+    }
+    fill(count_.begin(), count_.end(), 0);
+    for (auto& bucket : active_) bucket.clear();
+    highest_ = -1;
+    for (int v = 0; v < N_; ++v) {
+      ++count_[height_[v]];
+      arc_[v] = g_.offsets[v];
+      if (excess_[v] > 0 && v != sink_ && v != source_) activate(v);
+    }
+  }
+
+  void relabel(int u) {
+    ++relabels_;
+    const int old_height = height_[u];
+    int h = 2 * N_;
+    for (int k = g_.offsets[u]; k < g_.offsets[u + 1]; ++k) {
+      const Edge& e = edges_[g_.targets[k]];
+      if (e.cap > 0) h = min(h, height_[e.to] + 1);
+    }
+    setHeight(u, h);
+    if (count_[old_height] == 0 && old_height < N_) {
+      // Gap: everything between old_height and N is cut off from the sink.
+      for (int v = 0; v < N_; ++v) {
+        if (old_height < height_[v] && height_[v] < N_) {
+          setHeight(v, N_ + 1);
+          if (excess_[v] > 0 && v != u && v != sink_ && v != source_) activate(v);
+        }
+      }
+    }
+  }
+
+  void discharge(int u) {
+    while (excess_[u] > 0 && height_[u] < 2 * N_) {
+      if (arc_[u] == g_.offsets[u + 1]) {
+        relabel(u);
+        continue;
+      }
+      const int edge_idx = g_.targets[arc_[u]];
+      const Edge& e = edges_[edge_idx];
+      if (e.cap > 0 && height_[u] == height_[e.to] + 1) {
+        pushExcess(edge_idx, min(excess_[u], e.cap));
+      } else {
+        ++arc_[u];
+      }
+    }
+  }
 
+  // Leaves a maximum flow (not just a preflow) in edges_, so minCut()
+  // works as for MaxFlow.
+  T solve() {
+    g_.build();
+    if (source_ == sink_) return 0;
+    height_.assign(N_, 0);
+    height_[source_] = N_;
+    excess_.assign(N_, 0);
+    count_.assign(2 * N_ + 1, 0);
+    active_.assign(2 * N_, {});
+    arc_.resize(N_);
+    highest_ = -1;
+    for (int k = g_.offsets[source_]; k < g_.offsets[source_ + 1]; ++k) {
+      const int edge_idx = g_.targets[k];
+      const T cap = edges_[edge_idx].cap;
+      if (cap > 0) {
+        excess_[source_] += cap;
+        pushExcess(edge_idx, cap);
+      }
+    }
+    globalRelabel();
+    while (highest_ >= 0) {
+      if (active_[highest_].empty()) {
+        --highest_;
+        continue;
+      }
+      const int u = active_[highest_].back();
+      active_[highest_].pop_back();
+      // Stale entry: lifted by a gap and queued again at its new height.
+      if (height_[u] != highest_ || excess_[u] == 0) continue;
+      discharge(u);
+      if (relabels_ >= N_) globalRelabel();
+    }
+    this->buildLevels();
+    return excess_[sink_];
+  }
+};
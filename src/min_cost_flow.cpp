@@ -0,0 +1,202 @@
+// Minimum cost flow on the edges of MaxFlow. Each edge also has a cost per
+// unit of flow, and its reverse edge has the opposite cost.
+// - SUCCESSIVE_SHORTEST_PATHS: augments along cheapest paths, found by
+//   Dijkstra on reduced costs (Johnson potentials). Negative costs are
+//   allowed if there is no negative cycle: the potentials then start from
+//   Bellman-Ford. O(F (E log V)) for a flow of F.
+// - CAPACITY_SCALING: sends Delta units at a time, for Delta = 2^k down to
+//   1. O(E log U (E log V)) for capacities up to U, so large capacities
+//   don't matter. Negative cycles are fine too.
+// T must be an integer type.
+// Requires MaxFlow (max_flow.cpp), CSRGraph (csr_graph.cpp) and
+// DaryHeap (dijkstra.cpp).
+//
+// MinCostFlow<int64_t> f(N, source, sink);
+// f.addEdge(from, to, cap, cost);
+// auto [flow, cost] = f.solve();
+template <typename T>
+class MinCostFlow : public MaxFlow<T> {
+ public:
+  using typename MaxFlow<T>::Edge;
+  using MaxFlow<T>::g_;
+  using MaxFlow<T>::edges_;
+  using MaxFlow<T>::source_;
+  using MaxFlow<T>::sink_;
+  using MaxFlow<T>::N_;
+
+  enum Mode { SUCCESSIVE_SHORTEST_PATHS, CAPACITY_SCALING };
+
+  const T INFTY = numeric_limits<T>::max();
+
+  vector<T> cost_;  // Indexed like edges_.
+  vector<T> potential_;
+  vector<T> dist_;
+  vector<int> parent_;  // Edge index into each vertex on its shortest path.
+  vector<T> excess_;  // CAPACITY_SCALING only.
+  vector<int> sources_;
+  DaryHeap heap_;
+
+  MinCostFlow(int N, int source, int sink) : MaxFlow<T>(N, source, sink) {}
+
+  void addEdge(int from, int to, T cap, T cost) {
+    if (from != to) {
+      cost_.push_back(cost);
+      cost_.push_back(-cost);
+    }
+    MaxFlow<T>::addEdge(from, to, cap);
+  }
+
+  T reducedCost(int edge_idx) const {
+    const Edge& e = edges_[edge_idx];
+    return cost_[edge_idx] + potential_[e.from] - potential_[e.to];
+  }
+
+  // Bellman-Ford from the source if some residual edge has a negative
+  // cost, so that all reduced costs start non-negative.
+  void initPotentials() {
+    potential_.assign(N_, 0);
+    bool negative = false;
+    for (int edge_idx = 0; edge_idx < (int) edges_.size(); ++edge_idx) {
+      if (edges_[edge_idx].cap > 0 && cost_[edge_idx] < 0) negative = true;
+    }
+    if (!negative) return;
+    dist_.assign(N_, INFTY);
+    dist_[source_] = 0;
+    for (int round = 0; round < N_; ++round) {
+      bool changed = false;
+      for (int edge_idx = 0; edge_idx < (int) edges_.size(); ++edge_idx) {
+        const Edge& e = edges_[edge_idx];
+        if (e.cap > 0 && dist_[e.from] != INFTY && dist_[e.from] + cost_[edge_idx] < dist_[e.to]) {
+          dist_[e.to] = dist_[e.from] + cost_[edge_idx];
+          changed = true;
+        }
+      }
+      if (!changed) break;
+    }
+    // Vertices the source can't reach never will, their potential is unused.
+    for (int v = 0; v < N_; ++v) {
+      if (dist_[v] != INFTY) potential_[v] = dist_[v];
+    }
+  }
+
+  // Dijkstra by reduced cost from all sources_, over the edges with at
+  // least min_cap residual capacity. Stops at the first vertex for which
+  // is_target is true and returns it, -1 if there is none. Potentials are
+  // then raised by min(dist, dist[target]), which keeps reduced costs
+  // non-negative and makes them 0 along the path.
+  template <class IsTarget>
+  int shortestPath(T min_cap, IsTarget is_target) {
+    dist_.assign(N_, INFTY);
+    parent_.assign(N_, -1);
+    heap_.reserve(N_);
+    for (int s : sources_) {
+      dist_[s] = 0;
+      heap_.push(0, s);
+    }
+    int target = -1;
+    while (!heap_.empty()) {
+      const int u = heap_.pop().second;
+      if (is_target(u)) {
+        target = u;
+        break;
+      }
+      for (int k = g_.offsets[u]; k < g_.offsets[u + 1]; ++k) {
+        const int edge_idx = g_.targets[k];
+        const Edge& e = edges_[edge_idx];
+        if (e.cap < min_cap) continue;
+        const T d = dist_[u] + reducedCost(edge_idx);
+        if (d < dist_[e.to]) {
+          dist_[e.to] = d;
+          parent_[e.to] = edge_idx;
+          heap_.push(d, e.to);
+        }
+      }
+    }
+    heap_.clear();
+    if (target != -1) {
+      for (int v = 0; v < N_; ++v) {
+        potential_[v] += min(dist_[v], dist_[target]);
+      }
+    }
+    return target;
+  }
+
+  T successiveShortestPaths(T limit) {
+    initPotentials();
+    sources_.assign(1, source_);
+    T flow = 0;
+    while (flow < limit && shortestPath(1, [&](int v) { return v == sink_; }) != -1) {
+      T path_flow = limit - flow;
+      for (int v = sink_; v != source_; v = edges_[parent_[v]].from) {
+        path_flow = min(path_flow, edges_[parent_[v]].cap);
+      }
+      for (int v = sink_; v != source_; v = edges_[parent_[v]].from) {
+        this->push(parent_[v], path_flow);
+      }
+      flow += path_flow;
+    }
+    return flow;
+  }
+
+  // Moves all the residual capacity of edge_idx, tracking excesses.
+  void saturate(int edge_idx) {
+    const T cap = edges_[edge_idx].cap;
+    excess_[edges_[edge_idx].from] -= cap;
+    excess_[edges_[edge_idx].to] += cap;
+    this->push(edge_idx, cap);
+  }
+
+  // The flow value is fixed up front (max flow by Dinic on a copy), then
+  // the source gets that much excess and the sink that much deficit.
+  // Each phase first saturates the edges with negative reduced cost, then
+  // moves Delta units from excesses to deficits along cheapest paths.
+  T capacityScaling(T limit) {
+    MaxFlow<T> probe = *this;
+    const T flow = min(limit, probe.solve());
+    potential_.assign(N_, 0);
+    excess_.assign(N_, 0);
+    excess_[source_] = flow;
+    excess_[sink_] = -flow;
+    T max_cap = flow;
+    for (const Edge& e : edges_) {
+      max_cap = max(max_cap, e.cap);
+    }
+    T delta = 1;
+    while (delta <= max_cap / 2) delta *= 2;
+    for (; delta >= 1; delta /= 2) {
+      for (int edge_idx = 0; edge_idx < (int) edges_.size(); ++edge_idx) {
+        if (edges_[edge_idx].cap >= delta && reducedCost(edge_idx) < 0) saturate(edge_idx);
+      }
+      while (true) {
+        sources_.clear();
+        for (int v = 0; v < N_; ++v) {
+          if (excess_[v] >= delta) sources_.push_back(v);
+        }
+        if (sources_.empty()) break;
+        const int target = shortestPath(delta, [&](int v) { return excess_[v] <= -delta; });
+        if (target == -1) break;
+        int v = target;
+        for (; parent_[v] != -1; v = edges_[parent_[v]].from) {
+          this->push(parent_[v], delta);
+        }
+        excess_[v] -= delta;
+        excess_[target] += delta;
+      }
+    }
+    return flow;
+  }
+
+  // Sends min(limit, max flow) units from source to sink at minimum total
+  // cost. Returns { flow, cost }.
+  pair<T, T> solve(T limit = numeric_limits<T>::max(), Mode mode = SUCCESSIVE_SHORTEST_PATHS) {
+    g_.build();
+    if (source_ == sink_) return { 0, 0 };
+    const T flow = (mode == SUCCESSIVE_SHORTEST_PATHS) ? successiveShortestPaths(limit)
+                                                       : capacityScaling(limit);
+    T cost = 0;
+    for (int edge_idx = 0; edge_idx < (int) edges_.size(); edge_idx += 2) {
+      cost += edges_[edge_idx].flow * cost_[edge_idx];
+    }
+    return { flow, cost };
+  }
+};
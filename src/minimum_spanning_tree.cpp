@@ -5,15 +5,28 @@ struct Edge {
 };
 
 // Prim's algorithm
+// Requires CSRGraph (csr_graph.cpp).
 template <typename T>
 class MinimumSpanningTree {
  private:
   int N_;
-  vector<vector<Edge>> g_; // Adjacency list.
+  CSRGraph<T> g_; // Adjacency list in CSR format, weights are distances.
 
  public:
-  MinimumSpanningTree(const vector<vector<Edge>> g) :
-    g_(g), N_(g.size()) {}
+  MinimumSpanningTree(const vector<vector<Edge>>& g) : N_(g.size()), g_(g.size()) {
+    for (int u = 0; u < N_; ++u) {
+      for (const Edge& e : g[u]) {
+        g_.addEdge(u, e.to, e.dist);
+      }
+    }
+    g_.build();
+  }
+
+  // Undirected: g needs both directions of every edge.
+  MinimumSpanningTree(CSRGraph<T> g) : N_(g.N), g_(move(g)) {
+    g_.build();
+    assert(g_.weights.size() == g_.targets.size());
+  }
 
   // Uses lazy deletion instead of decrease-key operations.
   T solve() {
@@ -31,9 +44,9 @@ class MinimumSpanningTree {
       if (p.first < dist[p.second]) {
         dist[p.second] = 0;
         weight += p.first;
-        for (int i = 0; i < g_[p.second].size(); ++i) {
-          const T d = g_[p.second][i].dist;
-          const int to = g_[p.second][i].to;
+        for (int e = g_.offsets[p.second]; e < g_.offsets[p.second + 1]; ++e) {
+          const T d = g_.weights[e];
+          const int to = g_.targets[e];
           if (d < dist[to]) {
             q.push({ d, to });
           }
@@ -0,0 +1,93 @@
+// Position of (x, y) along the Hilbert curve that fills a 2^pow x 2^pow
+// grid. Consecutive queries in this order have nearby (left, right), so
+// the total pointer movement is O(N sqrt(Q)) with a better constant than
+// the classic block order.
+int64_t hilbertOrder(int x, int y, int pow, int rotate = 0) {
+  if (pow == 0) return 0;
+  const int half = 1 << (pow - 1);
+  int segment = (x < half) ? ((y < half) ? 0 : 3) : ((y < half) ? 1 : 2);
+  segment = (segment + rotate) & 3;
+  const int rotate_delta[4] = { 3, 0, 0, 1 };
+  const int next_x = x & (x ^ half);
+  const int next_y = y & (y ^ half);
+  const int next_rotate = (rotate + rotate_delta[segment]) & 3;
+  const int64_t sub_square_size = int64_t(1) << (2 * pow - 2);
+  const int64_t sub_order = hilbertOrder(next_x, next_y, pow - 1, next_rotate);
+  return segment * sub_square_size +
+         ((segment == 1 || segment == 2) ? sub_order : sub_square_size - sub_order - 1);
+}
+
+// Mo's algorithm for offline range queries [left, right] over an array
+// of size N, e.g. number of distinct values or mode frequency.
+// - add(i): element i enters the current window.
+// - remove(i): element i leaves the current window.
+// - answer(q): the window is now queries[q], record its answer.
+// Time: O((N + Q) sqrt(N)) calls to add/remove.
+//
+// vector<int> count(max_value + 1), answers(Q);
+// int distinct = 0;
+// mo(N, queries,
+//    [&](int i) { if (count[a[i]]++ == 0) ++distinct; },
+//    [&](int i) { if (--count[a[i]] == 0) --distinct; },
+//    [&](int q) { answers[q] = distinct; });
+template <class Add, class Remove, class Answer>
+void mo(int N, const vector<pair<int, int>>& queries, Add add, Remove remove, Answer answer) {
+  const int Q = queries.size();
+  int pow = 0;
+  while ((1 << pow) < N) ++pow;
+  vector<int64_t> order(Q);
+  for (int q = 0; q < Q; ++q) {
+    order[q] = hilbertOrder(queries[q].first, queries[q].second, pow);
+  }
+  vector<int> sorted(Q);
+  iota(sorted.begin(), sorted.end(), 0);
+  sort(sorted.begin(), sorted.end(), [&](int a, int b) { return order[a] < order[b]; });
+
+  // Current window is [left, right], initially empty.
+  int left = 0;
+  int right = -1;
+  for (int q : sorted) {
+    // Grow before shrinking so the window never has negative size.
+    while (left > queries[q].first) add(--left);
+    while (right < queries[q].second) add(++right);
+    while (left < queries[q].first) remove(left++);
+    while (right > queries[q].second) remove(right--);
+    answer(q);
+  }
+}
+
+// Mo's algorithm with point updates.
+// queries[q] = { left, right, time } where time is the number of updates
+// that happened before the query.
+// - add(i), remove(i), answer(q): as in mo.
+// - toggle(u, left, right): apply update u if it isn't applied, undo it
+//   if it is, given the current window [left, right]. Typically the update
+//   swaps a stored value with a[position], wrapped in remove/add when
+//   position is inside the window, so applying twice undoes it.
+// Time: O(N^(5/3)) calls for Q ~ N.
+template <class Add, class Remove, class Toggle, class Answer>
+void moWithUpdates(int N, const vector<array<int, 3>>& queries,
+                   Add add, Remove remove, Toggle toggle, Answer answer) {
+  const int Q = queries.size();
+  const int block = max(1, (int) cbrt((double) N * N));
+  vector<int> sorted(Q);
+  iota(sorted.begin(), sorted.end(), 0);
+  sort(sorted.begin(), sorted.end(), [&](int a, int b) {
+    const array<int, 3> key_a = { queries[a][0] / block, queries[a][1] / block, queries[a][2] };
+    const array<int, 3> key_b = { queries[b][0] / block, queries[b][1] / block, queries[b][2] };
+    return key_a < key_b;
+  });
+
+  int left = 0;
+  int right = -1;
+  int time = 0;  // Number of applied updates.
+  for (int q : sorted) {
+    while (left > queries[q][0]) add(--left);
+    while (right < queries[q][1]) add(++right);
+    while (left < queries[q][0]) remove(left++);
+    while (right > queries[q][1]) remove(right--);
+    while (time < queries[q][2]) toggle(time++, left, right);
+    while (time > queries[q][2]) toggle(--time, left, right);
+    answer(q);
+  }
+}
@@ -1,41 +1,56 @@
 // Array whose prefix sums from 0 to i are equal
 // to the value at location i.
-// Update range: O(1)
-// Query value: O(N)
+// Update range: O(log N)
+// Query value: O(log N)
 // getSums returns all values in O(N)
+// Requires FenwickTree (fenwick_tree.cpp).
+template <class T>
 class CyclicRangeArray {
  private:
-  vector<int> values_;
+  vector<T> values_;
+  // Fenwick tree over values_ for online point queries.
+  FenwickTree<T> tree_;
   int N_;
 
+  void addValue(int index, T delta) {
+    values_[index] += delta;
+    tree_.add(index, delta);
+  }
+
  public:
-  CyclicRangeArray(const vector<int>& values) :
-    values_(values), N_(values.size()) {}
+  CyclicRangeArray(const vector<T>& values) :
+    values_(values), tree_(values), N_(values.size()) {}
 
   // Cyclic array, therefore left can be greater than right.
-  // Note: increments by 1.
-  void updateRange(int left, int right) {
-    ++values_[left];
-
-    if (right >= left) {
-      if (right + 1 != N_) {
-        --values_[right + 1];
-      }
-    } else if (right < left) {
-      if (right + 1 != N_) {
-        --values_[right + 1];
-        ++values_[0];
-      }
+  void updateRange(int left, int right, T delta = 1) {
+    addValue(left, delta);
+    if (right + 1 != N_) {
+      addValue(right + 1, -delta);
+    }
+    if (right < left) {
+      // Wraps around, so [0, right] is covered too.
+      addValue(0, delta);
     }
   }
 
-  // Convert range array to sums.
-  vector<int> getSums() {
-    vector<int> sums(N_, 0);
-    sums[0] = values_[0];
-    for (int i = 1; i < N_; ++i) {
-      sums[i] = sums[i - 1] + values_[i];
+  T get(int index) const {
+    return tree_.prefixSum(index);
+  }
+
+  // Convert range array to sums, written into sums without allocating
+  // when it already has size N.
+  void getSums(vector<T>& sums) const {
+    sums.resize(N_);
+    T sum = 0;
+    for (int i = 0; i < N_; ++i) {
+      sum += values_[i];
+      sums[i] = sum;
     }
+  }
+
+  vector<T> getSums() const {
+    vector<T> sums;
+    getSums(sums);
     return sums;
   }
 };
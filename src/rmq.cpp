@@ -1,94 +1,217 @@
+// Floor of log2(x), x > 0.
+inline int floorLog2(unsigned x) {
+  return 31 - __builtin_clz(x);
+}
+
 // Returns the value, not the index.
+// Sparse table stored level-major in one array:
+// table[j * N + i] = max of [i, i + 2^j).
+// Build: O(N log N)
+// Query: O(1)
 template <class T>
 struct RangeMaximumQuery {
-  vector<T> arr;
-  vector<vector<T>> table;
+  int N;
+  vector<T> table;
 
-  RangeMaximumQuery(const vector<T>& a) : arr(a) {
-    precompute();
+  RangeMaximumQuery(const vector<T>& a) : N(a.size()) {
+    precompute(a);
   };
 
-  void precompute() {
-    int N = arr.size();
-    int logN = log2(N);
-    table = vector<vector<T>>(N, vector<T>(logN + 1));
+  void precompute(const vector<T>& a) {
+    const int levels = N > 0 ? floorLog2(N) + 1 : 0;
+    table.resize(levels * N);
 
     // Bottom up DP. Base cases.
-    for (int i = 0; i < N; ++i) {
-      table[i][0] = arr[i];
-    }
+    copy(a.begin(), a.end(), table.begin());
 
-    // Recursion. Loop over length (i.e. j) should be first.
-    for (int j = 1; j < logN + 1; ++j) {
-      for (int i = 0; i + (1 << j) - 1 < N; ++i) {
-        table[i][j] = max(table[i][j - 1],
-                          table[i + (1 << (j - 1))][j - 1]);
+    // Recursion. Every level only reads the previous one, contiguously.
+    for (int j = 1; j < levels; ++j) {
+      const T* previous = &table[(j - 1) * N];
+      T* current = &table[j * N];
+      const int half = 1 << (j - 1);
+      for (int i = 0; i + (1 << j) <= N; ++i) {
+        current[i] = max(previous[i], previous[i + half]);
       }
     }
   }
 
-  int query(int left, int right) {
-    if (left == right) return table[left][0];
-    int k = log2(right - left);
-    T answer = max(table[left][k],
-                   table[right - (1 << k) + 1][k]);
-    return answer;
+  T query(int left, int right) const {
+    const int k = floorLog2(right - left + 1);
+    const T* level = &table[k * N];
+    return max(level[left], level[right - (1 << k) + 1]);
   }
 };
 
 // Returns the index, not the value.
 // If there are multiple minima, it takes the rightmost minimum.
+// Sparse table of int32 indices stored level-major in one array:
+// table[j * N + i] = index of the minimum of [i, i + 2^j).
+// Build: O(N log N)
+// Query: O(1)
 template <class T>
 struct RangeMinimumQuery {
+  int N;
   vector<T> arr;
-  vector<vector<T>> table;
+  vector<int32_t> table;
 
-  RangeMinimumQuery() {}
+  RangeMinimumQuery() : N(0) {}
 
-  RangeMinimumQuery(const vector<T>& a) : arr(a) {
+  RangeMinimumQuery(const vector<T>& a) : N(a.size()), arr(a) {
     precompute();
   };
 
+  // a lies left of b, so taking b on ties takes the rightmost minimum.
+  int32_t better(int32_t a, int32_t b) const {
+    return arr[b] <= arr[a] ? b : a;
+  }
+
   void precompute() {
-    int N = arr.size();
-    int logN = log2(N);
-    table = vector<vector<T>>(N, vector<T>(logN + 1));
+    const int levels = N > 0 ? floorLog2(N) + 1 : 0;
+    table.resize(levels * N);
 
     // Bottom up DP. Base cases.
-    for (int i = 0; i < N; ++i) {
-      table[i][0] = i;
+    iota(table.begin(), table.begin() + N, 0);
+
+    // Recursion. Every level only reads the previous one, contiguously.
+    for (int j = 1; j < levels; ++j) {
+      const int32_t* previous = &table[(j - 1) * N];
+      int32_t* current = &table[j * N];
+      const int half = 1 << (j - 1);
+      for (int i = 0; i + (1 << j) <= N; ++i) {
+        current[i] = better(previous[i], previous[i + half]);
+      }
     }
+  }
+
+  int query(int left, int right) const {
+    const int k = floorLog2(right - left + 1);
+    const int32_t* level = &table[k * N];
+    // When the two halves overlap and share the minimum, the rightmost
+    // minimum of the right half is also the rightmost overall.
+    return better(level[left], level[right - (1 << k) + 1]);
+  }
+};
+
+// Drop-in alternative to RangeMinimumQuery with O(N) memory.
+// Returns the index, not the value.
+// If there are multiple minima, it takes the rightmost minimum.
+// The array is cut into blocks of 64. Within a block, masks[i] is the
+// monotonic stack of positions (as bits) that are the rightmost minimum
+// of some range ending at i, so an in-block query is one mask and one
+// __builtin_ctzll. Across blocks, a sparse table over the block minima
+// answers the middle part.
+// Build: O(N)
+// Query: O(1)
+template <class T>
+struct LinearRangeMinimumQuery {
+  static const int BLOCK = 64;
+
+  int N;
+  vector<T> arr;
+  vector<uint64_t> masks;
+  vector<int32_t> block_min_index;
+  RangeMinimumQuery<T> block_rmq;
+
+  LinearRangeMinimumQuery() : N(0) {}
+
+  LinearRangeMinimumQuery(const vector<T>& a) : N(a.size()), arr(a), masks(a.size()) {
+    precompute();
+  }
 
-    // Recursion. Loop over length (i.e. j) should be first.
-    for (int j = 1; j < logN + 1; ++j) {
-      for (int i = 0; i + (1 << j) - 1 < N; ++i) {
-        const int a = table[i][j - 1];
-        const int b = table[i + (1 << (j - 1))][j - 1];
-        if (arr[a] == arr[b]) {
-          // Take rightmost minimum value.
-          table[i][j] = max(a, b);
-        } else if (arr[a] < arr[b]) {
-          table[i][j] = a;
-        } else {
-          table[i][j] = b;
+  void precompute() {
+    vector<T> block_min;
+    for (int start = 0; start < N; start += BLOCK) {
+      const int end = min(N, start + BLOCK);
+      uint64_t stack = 0;
+      for (int i = start; i < end; ++i) {
+        // Positions with a value >= arr[i] can't be the rightmost minimum
+        // of any range ending at i or later.
+        while (stack != 0) {
+          const int top = 63 - __builtin_clzll(stack);
+          if (arr[start + top] < arr[i]) break;
+          stack ^= uint64_t(1) << top;
         }
+        stack |= uint64_t(1) << (i - start);
+        masks[i] = stack;
       }
+      block_min_index.push_back(inBlock(start, end - 1));
+      block_min.push_back(arr[block_min_index.back()]);
     }
+    block_rmq = RangeMinimumQuery<T>(block_min);
+  }
+
+  // left and right in the same block.
+  int inBlock(int left, int right) const {
+    const int start = left / BLOCK * BLOCK;
+    return start + __builtin_ctzll(masks[right] & (~uint64_t(0) << (left - start)));
+  }
+
+  // a lies left of b, so taking b on ties takes the rightmost minimum.
+  int better(int a, int b) const {
+    return arr[b] <= arr[a] ? b : a;
+  }
+
+  int query(int left, int right) const {
+    const int left_block = left / BLOCK;
+    const int right_block = right / BLOCK;
+    if (left_block == right_block) {
+      return inBlock(left, right);
+    }
+    int answer = inBlock(left, left_block * BLOCK + BLOCK - 1);
+    if (left_block + 1 < right_block) {
+      answer = better(answer, block_min_index[block_rmq.query(left_block + 1, right_block - 1)]);
+    }
+    return better(answer, inBlock(right_block * BLOCK, right));
+  }
+};
+
+// Disjoint sparse table: range queries over any associative op (sum,
+// product of mod_int, matrix product, ...), idempotency not needed.
+// On level h the array is cut into blocks of 2^(h + 1). For each block
+// with middle mid, the table stores op over [i, mid) for i in the left
+// half and op over [mid, i] for i in the right half. A query [l, r]
+// crosses exactly one such middle: the one on level floorLog2(l ^ r).
+// Stored level-major in one array: table[h * N + i].
+// Build: O(N log N)
+// Query: O(1), one op.
+//
+// DisjointSparseTable<mod_int, multiplies<mod_int>> dst(elements);
+template <class T, class Op = plus<T>>
+struct DisjointSparseTable {
+  int N;
+  Op op;
+  vector<T> arr;
+  vector<T> table;
+
+  DisjointSparseTable(const vector<T>& a, Op op = Op()) : N(a.size()), op(op), arr(a) {
+    precompute();
   }
 
-  int query(int left, int right) {
-    if (left == right) return table[left][0];
-    int k = log2(right - left);
-
-    const int a = table[left][k];
-    const int b = table[right - (1 << k) + 1][k];
-    if (arr[a] == arr[b]) {
-      // Take rightmost minimum value.
-      return max(a, b);
-    } else if (arr[a] < arr[b]) {
-      return a;
-    } else {
-      return b;
+  void precompute() {
+    const int levels = N > 1 ? floorLog2(N - 1) + 1 : 0;
+    table.resize(levels * N);
+    for (int h = 0; h < levels; ++h) {
+      T* level = &table[h * N];
+      const int half = 1 << h;
+      for (int mid = half; mid < N; mid += 2 * half) {
+        // Left half, suffixes ending at mid - 1.
+        level[mid - 1] = arr[mid - 1];
+        for (int i = mid - 2; i >= mid - half; --i) {
+          level[i] = op(arr[i], level[i + 1]);
+        }
+        // Right half, prefixes starting at mid.
+        level[mid] = arr[mid];
+        for (int i = mid + 1; i < min(mid + half, N); ++i) {
+          level[i] = op(level[i - 1], arr[i]);
+        }
+      }
     }
   }
+
+  // Inclusive range [left, right].
+  T query(int left, int right) const {
+    if (left == right) return arr[left];
+    const T* level = &table[floorLog2(left ^ right) * N];
+    return op(level[left], level[right]);
+  }
 };
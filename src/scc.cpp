@@ -1,39 +1,65 @@
+// Requires CSRGraph (csr_graph.cpp).
 class SCC {
  public:
   int N;
-  vector<vector<int>> graph;
-  vector<vector<int>> reverse_graph;
+  CSRGraph<> graph;
+  // Only built by findSCC, findSCCTarjan doesn't need it.
+  CSRGraph<> reverse_graph;
 
-  SCC(const vector<vector<int>>& g) : graph(g), N(g.size()), reverse_graph(g.size()) {
-    for (int i = 0; i < g.size(); ++i) {
-      for (int j : g[i]) {
-        reverse_graph[j].push_back(i);
-      }
-    }
+  SCC(const vector<vector<int>>& g) : SCC(CSRGraph<>(g)) {}
+
+  // Pass the graph with move() to avoid copying it.
+  SCC(CSRGraph<> g) : N(g.N), graph(move(g)) {
+    graph.build();
   }
 
-  void dfsForwardStep(int u, vector<bool>& visited, vector<int>& order) {
-    visited[u] = true;
-    for (int v : graph[u]) {
-      if (!visited[v]) {
-        dfsForwardStep(v, visited, order);
+  // Explicit stack of { vertex, next edge } instead of recursion, so
+  // long paths don't overflow the call stack.
+  vector<pair<int, int>> stack_;
+
+  void dfsForwardStep(int start, vector<bool>& visited, vector<int>& order) {
+    visited[start] = true;
+    stack_.push_back({ start, graph.offsets[start] });
+    while (!stack_.empty()) {
+      const int u = stack_.back().first;
+      int& e = stack_.back().second;
+      if (e < graph.offsets[u + 1]) {
+        const int v = graph.targets[e++];
+        if (!visited[v]) {
+          visited[v] = true;
+          stack_.push_back({ v, graph.offsets[v] });
+        }
+      } else {
+        // All children done.
+        order.push_back(u);
+        stack_.pop_back();
       }
     }
-    order.push_back(u);
   }
 
-  void dfsBackwardStep(int u, vector<bool>& visited, vector<int>& scc_index) {
-    visited[u] = true;
-    for (int v : reverse_graph[u]) {
-      if (!visited[v]) {
-        scc_index[v] = scc_index[u];
-        dfsBackwardStep(v, visited, scc_index);
+  void dfsBackwardStep(int start, vector<bool>& visited, vector<int>& scc_index) {
+    visited[start] = true;
+    stack_.push_back({ start, 0 });
+    while (!stack_.empty()) {
+      const int u = stack_.back().first;
+      stack_.pop_back();
+      for (int e = reverse_graph.offsets[u]; e < reverse_graph.offsets[u + 1]; ++e) {
+        const int v = reverse_graph.targets[e];
+        if (!visited[v]) {
+          visited[v] = true;
+          scc_index[v] = scc_index[u];
+          stack_.push_back({ v, 0 });
+        }
       }
     }
   }
 
   // Kosaraju's SCC algorithm.
   vector<int> findSCC() {
+    if (reverse_graph.N != N) {
+      reverse_graph = graph.reversed();
+    }
+
     // Forward step: find SCC order.
     vector<int> order;
     vector<bool> visited(N, false);
@@ -57,4 +83,57 @@ class SCC {
     }
     return scc_index;
   }
+
+  // Tarjan's SCC algorithm: a single DFS, no reverse graph needed.
+  // Returns the same numbering as findSCC: Tarjan completes the SCCs in
+  // reverse topological order, so the numbers are flipped at the end.
+  vector<int> findSCCTarjan() {
+    vector<int> index(N, -1);  // Discovery time.
+    vector<int> low(N);  // Lowest discovery time reachable within the subtree.
+    vector<int> scc_index(N, -1);
+    vector<int> component;  // Vertices not yet assigned to an SCC.
+    int time = 0;
+    int num_scc = 0;
+    for (int i = 0; i < N; ++i) {
+      if (index[i] != -1) continue;
+      index[i] = low[i] = time++;
+      component.push_back(i);
+      stack_.push_back({ i, graph.offsets[i] });
+      while (!stack_.empty()) {
+        const int u = stack_.back().first;
+        int& e = stack_.back().second;
+        if (e < graph.offsets[u + 1]) {
+          const int v = graph.targets[e++];
+          if (index[v] == -1) {
+            index[v] = low[v] = time++;
+            component.push_back(v);
+            stack_.push_back({ v, graph.offsets[v] });
+          } else if (scc_index[v] == -1) {
+            // v is still on the component stack.
+            low[u] = min(low[u], index[v]);
+          }
+        } else {
+          if (low[u] == index[u]) {
+            // u is the root of an SCC.
+            int v;
+            do {
+              v = component.back();
+              component.pop_back();
+              scc_index[v] = num_scc;
+            } while (v != u);
+            ++num_scc;
+          }
+          stack_.pop_back();
+          if (!stack_.empty()) {
+            const int parent = stack_.back().first;
+            low[parent] = min(low[parent], low[u]);
+          }
+        }
+      }
+    }
+    for (int& c : scc_index) {
+      c = num_scc - 1 - c;
+    }
+    return scc_index;
+  }
 };
@@ -1,442 +1,960 @@
-// Sum
 template <class T>
+struct Min {
+  T operator()(const T& a, const T& b) const { return min(a, b); }
+};
+
+template <class T>
+struct Max {
+  T operator()(const T& a, const T& b) const { return max(a, b); }
+};
+
+// Generic segment tree over a monoid (an associative op with an identity).
+// All nodes live in one array in "heap format": the root is at index 1,
+// node k has children 2k and 2k + 1, and the leaves are stored at
+// [size, 2 * size) where size is N rounded up to a power of two.
+// Build: O(N)
+// Query, pointSet: O(log N), iterative bottom-up.
+//
+// Sum: SegTree<int64_t> st(elements, 0);
+// Min: SegTree<int64_t, Min<int64_t>> st(elements, numeric_limits<int64_t>::max());
+template <class T, class Op = plus<T>>
 struct SegTree {
-  const T BAD_VALUE = -1;
-  int leftmost;
-  int rightmost;
-  shared_ptr<SegTree> left_child = nullptr;
-  shared_ptr<SegTree> right_child = nullptr;
-  T sum;
-
-  SegTree(int leftmost, int rightmost, const vector<T>& elements) {
-    this->leftmost = leftmost;
-    this->rightmost = rightmost;
-    if (leftmost == rightmost) {
-      sum = elements[leftmost];
-    } else {
-      const int mid = (leftmost + rightmost) / 2;
-      left_child = make_shared<SegTree<T>>(leftmost, mid, elements);
-      right_child = make_shared<SegTree<T>>(mid + 1, rightmost, elements);
-      sum = left_child->sum + right_child->sum;
+  int N;
+  int size;
+  T identity;
+  Op op;
+  vector<T> tree;
+
+  SegTree(int N, T identity, Op op = Op()) : SegTree(vector<T>(N, identity), identity, op) {}
+
+  SegTree(const vector<T>& elements, T identity, Op op = Op()) :
+    N(elements.size()), identity(identity), op(op) {
+    size = 1;
+    while (size < N) size <<= 1;
+    tree.assign(2 * size, identity);
+    copy(elements.begin(), elements.end(), tree.begin() + size);
+    for (int k = size - 1; k >= 1; --k) {
+      pull(k);
     }
   }
 
-  T rangeSum(int left, int right) {
-    if (left > rightmost || right < leftmost) {
-      // Disjoint.
-      return BAD_VALUE;
-    } else if (leftmost >= left && rightmost <= right) {
-      // Completely contained within.
-      return sum;
-    } else {
-      T left_child_value = (left_child != nullptr) ? left_child->rangeSum(left, right) : BAD_VALUE;
-      T right_child_value = (right_child != nullptr) ? right_child->rangeSum(left, right) : BAD_VALUE;
-      if (left_child_value != BAD_VALUE && right_child_value != BAD_VALUE) {
-        return left_child_value + right_child_value;
-      } else if (left_child_value != BAD_VALUE) {
-        return left_child_value;
-      } else {
-        return right_child_value;
-      }
+  void pull(int k) {
+    tree[k] = op(tree[2 * k], tree[2 * k + 1]);
+  }
+
+  T get(int index) const {
+    return tree[index + size];
+  }
+
+  // Inclusive range [left, right]. Returns identity if the range is empty.
+  T query(int left, int right) const {
+    // Results of the left and right border are kept apart so the op
+    // does not need to be commutative.
+    T result_left = identity;
+    T result_right = identity;
+    for (left += size, right += size + 1; left < right; left >>= 1, right >>= 1) {
+      if (left & 1) result_left = op(result_left, tree[left++]);
+      if (right & 1) result_right = op(tree[--right], result_right);
     }
+    return op(result_left, result_right);
   }
 
   void pointSet(int index, T value) {
-    if (leftmost == rightmost) {
-      assert(leftmost == index);
-      sum = value;
-    } else {
-      assert(left_child != nullptr);
-      assert(right_child != nullptr);
-      if (index <= left_child->rightmost) {
-        left_child->pointSet(index, value);
-      } else {
-        right_child->pointSet(index, value);
-      }
-      sum = left_child->sum + right_child->sum;
+    index += size;
+    tree[index] = value;
+    for (index >>= 1; index >= 1; index >>= 1) {
+      pull(index);
     }
   }
-};
-
-// Old style implementation. Should rewrite this.
-// Implemented as Range Minimum Query, can be adapted to other queries.
-class SegmentTree {
- private:
-  vector<long long> elements_;
-  vector<long long> tree_; // In "heap format".
-  int N_; // Size of elements_.
-
-  long long INFTY = 1000000000000000;  // 1e15.
-
-  int left(int index) { return 2 * index + 1; }
-  int right(int index) { return 2 * index + 2; }
 
-  void build(int index, int l, int r) {
-    if (l == r) {
-      tree_[index] = l;
-    } else {
-      build(left(index), l, (l + r) / 2);
-      build(right(index), (l + r) / 2 + 1, r);
-      int i1 = tree_[left(index)];
-      int i2 = tree_[right(index)];
-      tree_[index] = (elements_[i1] <= elements_[i2]) ? i1 : i2;
+  // Recompute the ancestors of the given leaves, every ancestor only once.
+  void pullAncestors(vector<int> indices) {
+    if (indices.empty()) return;
+    for (int& k : indices) k += size;
+    sort(indices.begin(), indices.end());
+    // All leaves are on the same level, so the nodes stay sorted when
+    // going up and duplicates are adjacent.
+    while (indices[0] > 1) {
+      for (int& k : indices) k >>= 1;
+      indices.erase(unique(indices.begin(), indices.end()), indices.end());
+      for (int k : indices) pull(k);
     }
   }
 
-  int rmq(int index, int l, int r, int l_query, int r_query) {
-    // If [l, r] and [l_query, r_query] are disjoint.
-    if (l_query > r || r_query < l) return -1;
-
-    // If [l, r] is a subsegment of [l_query, r_query].
-    if (l_query <= l && r <= r_query) return tree_[index];
+  // Batch of { index, value } point updates.
+  void pointSet(const vector<pair<int, T>>& updates) {
+    vector<int> indices;
+    indices.reserve(updates.size());
+    for (const auto& p : updates) {
+      tree[p.first + size] = p.second;
+      indices.push_back(p.first);
+    }
+    pullAncestors(indices);
+  }
 
-    int i1 = rmq(left(index), l, (l + r) / 2, l_query, r_query);
-    int i2 = rmq(right(index), (l + r) / 2 + 1, r, l_query, r_query);
+  // Binary search on the tree, pred(identity) must be true and pred must
+  // be monotone. Returns the first index right >= left for which
+  // pred(query(left, right)) is false, or N if there is none.
+  // E.g. first index where the prefix sum from left reaches K:
+  //   maxRight(left, [&](T sum) { return sum < K; })
+  template <class Pred>
+  int maxRight(int left, Pred pred) const {
+    if (left == N) return N;
+    int k = left + size;
+    T sum = identity;
+    do {
+      while (k % 2 == 0) k >>= 1;
+      if (!pred(op(sum, tree[k]))) {
+        // Answer is inside the subtree of k: descend.
+        while (k < size) {
+          k = 2 * k;
+          if (pred(op(sum, tree[k]))) {
+            sum = op(sum, tree[k]);
+            ++k;
+          }
+        }
+        return k - size;
+      }
+      sum = op(sum, tree[k]);
+      ++k;
+    } while ((k & -k) != k);
+    return N;
+  }
 
-    if (i1 == -1 || i2 == -1) {
-      // Return the one that is valid.
-      return max(i1, i2);
-    } else {
-      // i1 and i2 are both valid indices.
-      return elements_[i1] <= elements_[i2] ? i1 : i2;
-    }
+  // Mirror of maxRight. Returns the last index left <= right for which
+  // pred(query(left, right)) is false, or -1 if there is none.
+  // E.g. first position left of i whose value is below X:
+  //   minLeft(i, [&](T minimum) { return minimum >= X; })
+  template <class Pred>
+  int minLeft(int right, Pred pred) const {
+    if (right < 0) return -1;
+    int k = right + size + 1;
+    T sum = identity;
+    do {
+      --k;
+      while (k > 1 && k % 2 == 1) k >>= 1;
+      if (!pred(op(tree[k], sum))) {
+        // Answer is inside the subtree of k: descend.
+        while (k < size) {
+          k = 2 * k + 1;
+          if (pred(op(tree[k], sum))) {
+            sum = op(tree[k], sum);
+            --k;
+          }
+        }
+        return k - size;
+      }
+      sum = op(tree[k], sum);
+    } while ((k & -k) != k);
+    return -1;
   }
+};
 
-  void update(int node_index, int l, int r, int element_index, long long value) {
-    if (l == r) {
-      // Leaf index.
-      tree_[node_index] = element_index;
-    } else {
-      int mid = (l + r) / 2;
-      if (element_index <= mid) {
-        // Recurse on left child.
-        update(left(node_index), l, mid, element_index, value);
-      } else {
-        // Recurse on right child.
-        update(right(node_index), mid + 1, r, element_index, value);
+// Range Minimum Query returning the index of the minimum.
+// If there are multiple minima, it takes the leftmost minimum.
+// The leaves of the SegTree store indices and the op compares the
+// elements they point to.
+class SegmentTree {
+ private:
+  struct IndexMin {
+    vector<long long> elements;
+
+    int operator()(int i1, int i2) const {
+      if (i1 == -1 || i2 == -1) {
+        // Return the one that is valid.
+        return max(i1, i2);
       }
-      int i1 = tree_[left(node_index)];
-      int i2 = tree_[right(node_index)];
-      tree_[node_index] = (elements_[i1] <= elements_[i2]) ? i1 : i2;
+      return elements[i1] <= elements[i2] ? i1 : i2;
     }
+  };
+
+  long long INFTY = 1000000000000000;  // 1e15.
+
+  SegTree<int, IndexMin> tree_;
+
+  static vector<int> indices(int N) {
+    vector<int> result(N);
+    iota(result.begin(), result.end(), 0);
+    return result;
   }
 
  public:
-  int rmq_index(int l_query, int r_query) {
+  SegmentTree(int number_of_elements) :
+    tree_(indices(number_of_elements), -1,
+          IndexMin{ vector<long long>(number_of_elements, INFTY) }) {}
+
+  // Bottom up build in O(N).
+  SegmentTree(const vector<long long>& elements) :
+    tree_(indices(elements.size()), -1, IndexMin{ elements }) {}
+
+  int rmq_index(int l_query, int r_query) const {
     if (l_query > r_query) {
       return -1;
     }
-    return rmq(0, 0, N_ - 1, l_query, r_query);
+    return tree_.query(l_query, r_query);
   }
 
-  long long rmq(int l_query, int r_query) {
+  long long rmq(int l_query, int r_query) const {
     int rmq_idx = rmq_index(l_query, r_query);
     if (rmq_idx == -1) {
       return INFTY;
     } else {
-      return elements_[rmq_idx];
+      return tree_.op.elements[rmq_idx];
     }
   }
 
   void update(int element_index, long long value) {
-    elements_[element_index] = value;
-    update(0, 0, N_ - 1, element_index, value);
+    tree_.op.elements[element_index] = value;
+    // Leaf keeps its index, the ancestors are recomputed.
+    tree_.pointSet(element_index, element_index);
+  }
+
+  // Batch of { index, value } updates. Ancestors shared by several
+  // updated elements are recomputed only once.
+  void update(const vector<pair<int, long long>>& updates) {
+    vector<int> element_indices;
+    element_indices.reserve(updates.size());
+    for (const auto& p : updates) {
+      tree_.op.elements[p.first] = p.second;
+      element_indices.push_back(p.first);
+    }
+    tree_.pullAncestors(element_indices);
+  }
+};
+
+// Lazy segment tree, generic over:
+// - a value monoid: S, op(S, S) and its identity e(),
+// - a lazy tag monoid: F, composition(f, g) = "apply g, then f" and its
+//   identity id(),
+// - an action mapping(f, x, len) that applies tag f to the value x of a
+//   node covering len elements.
+// Values and tags live in two flat arrays in "heap format" (see SegTree).
+// Nodes don't store their length: it follows from their level, because
+// size is a power of two.
+// Build: O(N)
+// Query, apply, pointSet: O(log N), iterative.
+//
+// LazySegTree<AddSum<int64_t>> st(elements);
+// st.apply(left, right, 5);  // Add 5 to [left, right].
+// st.query(left, right);     // Sum of [left, right].
+template <class M>
+struct LazySegTree {
+  using S = typename M::S;
+  using F = typename M::F;
+
+  int N;
+  int size;
+  int log;
+  M m;
+  vector<S> tree;
+  // Tags that haven't been propagated to the children yet. If lazy[k] is
+  // not the identity, the subtree of k is out of sync with its root k.
+  vector<F> lazy;
+
+  // All N elements start at initial.
+  LazySegTree(int N, S initial, M m = M()) : LazySegTree(vector<S>(N, initial), m) {}
+
+  LazySegTree(const vector<S>& elements, M m = M()) : N(elements.size()), m(m) {
+    log = 0;
+    while ((1 << log) < N) ++log;
+    size = 1 << log;
+    tree.assign(2 * size, m.e());
+    lazy.assign(size, m.id());
+    copy(elements.begin(), elements.end(), tree.begin() + size);
+    for (int k = size - 1; k >= 1; --k) {
+      pull(k);
+    }
+  }
+
+  int length(int k) const {
+    return size >> (31 - __builtin_clz(k));
+  }
+
+  void pull(int k) {
+    tree[k] = m.op(tree[2 * k], tree[2 * k + 1]);
+  }
+
+  void applyNode(int k, const F& f) {
+    tree[k] = m.mapping(f, tree[k], length(k));
+    if (k < size) lazy[k] = m.composition(f, lazy[k]);
+  }
+
+  // Propagate to the children.
+  void push(int k) {
+    applyNode(2 * k, lazy[k]);
+    applyNode(2 * k + 1, lazy[k]);
+    lazy[k] = m.id();
+  }
+
+  // Push all tags on the paths from the root to the borders of the
+  // half-open leaf range [l, r).
+  void pushBorders(int l, int r) {
+    for (int i = log; i >= 1; --i) {
+      if (((l >> i) << i) != l) push(l >> i);
+      if (((r >> i) << i) != r) push((r - 1) >> i);
+    }
+  }
+
+  S get(int index) {
+    index += size;
+    for (int i = log; i >= 1; --i) push(index >> i);
+    return tree[index];
   }
 
-  SegmentTree(int number_of_elements) {
-    N_ = number_of_elements;
-    elements_.resize(N_, INFTY);
-    tree_.assign(4 * N_, 0);
-    build(0, 0, N_ - 1);
+  void pointSet(int index, S value) {
+    index += size;
+    for (int i = log; i >= 1; --i) push(index >> i);
+    tree[index] = value;
+    for (int i = 1; i <= log; ++i) pull(index >> i);
+  }
+
+  // Inclusive range [left, right]. Returns e() if the range is empty.
+  S query(int left, int right) {
+    if (left > right) return m.e();
+    int l = left + size;
+    int r = right + size + 1;
+    pushBorders(l, r);
+    S result_left = m.e();
+    S result_right = m.e();
+    for (; l < r; l >>= 1, r >>= 1) {
+      if (l & 1) result_left = m.op(result_left, tree[l++]);
+      if (r & 1) result_right = m.op(tree[--r], result_right);
+    }
+    return m.op(result_left, result_right);
+  }
+
+  // Apply tag f to every element in [left, right].
+  void apply(int left, int right, const F& f) {
+    if (left > right) return;
+    int l = left + size;
+    int r = right + size + 1;
+    pushBorders(l, r);
+    for (int l2 = l, r2 = r; l2 < r2; l2 >>= 1, r2 >>= 1) {
+      if (l2 & 1) applyNode(l2++, f);
+      if (r2 & 1) applyNode(--r2, f);
+    }
+    for (int i = 1; i <= log; ++i) {
+      if (((l >> i) << i) != l) pull(l >> i);
+      if (((r >> i) << i) != r) pull((r - 1) >> i);
+    }
+  }
+
+  // Same contract as SegTree::maxRight.
+  template <class Pred>
+  int maxRight(int left, Pred pred) {
+    if (left == N) return N;
+    int k = left + size;
+    for (int i = log; i >= 1; --i) push(k >> i);
+    S sum = m.e();
+    do {
+      while (k % 2 == 0) k >>= 1;
+      if (!pred(m.op(sum, tree[k]))) {
+        while (k < size) {
+          push(k);
+          k = 2 * k;
+          if (pred(m.op(sum, tree[k]))) {
+            sum = m.op(sum, tree[k]);
+            ++k;
+          }
+        }
+        return k - size;
+      }
+      sum = m.op(sum, tree[k]);
+      ++k;
+    } while ((k & -k) != k);
+    return N;
+  }
+
+  // Same contract as SegTree::minLeft.
+  template <class Pred>
+  int minLeft(int right, Pred pred) {
+    if (right < 0) return -1;
+    int k = right + size + 1;
+    for (int i = log; i >= 1; --i) push((k - 1) >> i);
+    S sum = m.e();
+    do {
+      --k;
+      while (k > 1 && k % 2 == 1) k >>= 1;
+      if (!pred(m.op(tree[k], sum))) {
+        while (k < size) {
+          push(k);
+          k = 2 * k + 1;
+          if (pred(m.op(tree[k], sum))) {
+            sum = m.op(tree[k], sum);
+            --k;
+          }
+        }
+        return k - size;
+      }
+      sum = m.op(tree[k], sum);
+    } while ((k & -k) != k);
+    return -1;
   }
 };
 
-// Supports rangeAdd using lazy propagation.
+// rangeAdd + sum.
 template <class T>
-struct SegTree {
-  int leftmost;
-  int rightmost;
-  shared_ptr<SegTree> left_child = nullptr;
-  shared_ptr<SegTree> right_child = nullptr;
-  T sum;
-  // Propagation value that hasn't been propagated to its children.
-  // If prop is non-zero this means that "sum" variable of this node
-  // contains a different value than the sum of the left_child and
-  // right_child sum. It means that the subtree is out of sync with
-  // its root (root = this node).
-  T prop;
-
-  SegTree(int leftmost, int rightmost, const vector<T>& elements) {
-    this->leftmost = leftmost;
-    this->rightmost = rightmost;
-    prop = 0;
+struct AddSum {
+  using S = T;
+  using F = T;
+  S e() const { return 0; }
+  S op(const S& a, const S& b) const { return a + b; }
+  F id() const { return 0; }
+  S mapping(const F& f, const S& x, int len) const { return x + f * len; }
+  F composition(const F& f, const F& g) const { return f + g; }
+};
+
+// rangeAdd + min. The identity is numeric_limits<T>::max(), so start
+// from actual values: LazySegTree<AddMin<T>>(N, 0) for N zeros.
+template <class T>
+struct AddMin {
+  using S = T;
+  using F = T;
+  S e() const { return numeric_limits<T>::max(); }
+  S op(const S& a, const S& b) const { return min(a, b); }
+  F id() const { return 0; }
+  // The identity (e.g. padding past N) stays the identity.
+  S mapping(const F& f, const S& x, int) const { return x == e() ? x : x + f; }
+  F composition(const F& f, const F& g) const { return f + g; }
+};
+
+// setTo + rangeAdd + sum.
+// Tag is { is_set_to, value }
+// where value is "setTo" value when is_set_to = true
+// and value is "rangeAdd" value when is_set_to = false.
+template <class T>
+struct SetAddSum {
+  using S = T;
+  using F = pair<bool, T>;
+  S e() const { return 0; }
+  S op(const S& a, const S& b) const { return a + b; }
+  F id() const { return { false, 0 }; }
+  S mapping(const F& f, const S& x, int len) const {
+    return f.first ? f.second * len : x + f.second * len;
+  }
+  F composition(const F& f, const F& g) const {
+    // setTo overrides whatever was there before. Range add stays
+    // range add and setTo stays setTo, both with a higher value.
+    if (f.first) return f;
+    return { g.first, g.second + f.second };
+  }
+};
+
+// Affine map x -> b * x + c on every element + sum, e.g. over mod_int.
+// Tag is { b, c }.
+template <class T>
+struct AffineSum {
+  using S = T;
+  using F = pair<T, T>;
+  S e() const { return 0; }
+  S op(const S& a, const S& b) const { return a + b; }
+  F id() const { return { 1, 0 }; }
+  S mapping(const F& f, const S& x, int len) const {
+    return f.first * x + f.second * T(len);
+  }
+  F composition(const F& f, const F& g) const {
+    return { f.first * g.first, f.first * g.second + f.second };
+  }
+};
+
+// Persistent segment tree supporting sum and min.
+// Every update copies the O(log N) nodes on its path and returns the root
+// of the new version, old roots stay valid and queryable.
+// rangeAdd uses "permanent" tags that are never pushed down: a node's
+// sum and minimum include its own tag but not the tags of its ancestors.
+// Nodes are allocated from one pool (bump allocation into a vector),
+// children are indices into it.
+// Build: O(N)
+// Update, query: O(log N) time, O(log N) new nodes per update.
+//
+// PersistentSegTree<int64_t> pst(elements.size());
+// vector<int> roots = { pst.build(elements) };
+// roots.push_back(pst.rangeAdd(roots.back(), left, right, 5));
+// pst.sum(roots[0], left, right);  // Before the update.
+template <class T>
+struct PersistentSegTree {
+  struct Node {
+    int left_child;
+    int right_child;
+    T sum;
+    T minimum;
+    T add;
+  };
+
+  int N;
+  vector<Node> nodes;
+
+  // capacity: expected total number of nodes, e.g. 2N + Q * 4 * log(N).
+  PersistentSegTree(int N, int capacity = 0) : N(N) {
+    nodes.reserve(capacity);
+  }
+
+  int newNode(const Node& node) {
+    nodes.push_back(node);
+    return nodes.size() - 1;
+  }
+
+  void pull(Node& node, int len) {
+    const Node& left = nodes[node.left_child];
+    const Node& right = nodes[node.right_child];
+    node.sum = left.sum + right.sum + node.add * len;
+    node.minimum = min(left.minimum, right.minimum) + node.add;
+  }
+
+  int build(int leftmost, int rightmost, const vector<T>& elements) {
     if (leftmost == rightmost) {
-      sum = elements[leftmost];
-    } else {
-      const int mid = (leftmost + rightmost) / 2;
-      left_child = make_shared<SegTree<T>>(leftmost, mid, elements);
-      right_child = make_shared<SegTree<T>>(mid + 1, rightmost, elements);
-      sum = left_child->sum + right_child->sum;
+      const T value = elements[leftmost];
+      return newNode({ -1, -1, value, value, 0 });
     }
+    const int mid = (leftmost + rightmost) / 2;
+    Node node = { build(leftmost, mid, elements), build(mid + 1, rightmost, elements), 0, 0, 0 };
+    pull(node, rightmost - leftmost + 1);
+    return newNode(node);
   }
 
-  // Propagate to the subtree.
-  void propagate() {
-    // assert(left_child != nullptr && right_child != nullptr);
-    if (prop != 0) {
-      const int len_left_child = (left_child->rightmost - left_child->leftmost + 1);
-      left_child->sum += prop * len_left_child;
-      left_child->prop += prop;
+  // Returns the root of version 0, -1 if N is 0.
+  int build(const vector<T>& elements) {
+    if (N == 0) return -1;
+    return build(0, N - 1, elements);
+  }
 
-      const int len_right_child = (right_child->rightmost - right_child->leftmost + 1);
-      right_child->sum += prop * len_right_child;
-      right_child->prop += prop;
-      prop = 0;
+  // value is relative to the tags of the ancestors of k.
+  int pointSet(int k, int leftmost, int rightmost, int index, T value) {
+    Node node = nodes[k];
+    if (leftmost == rightmost) {
+      node = { -1, -1, value, value, 0 };
+      return newNode(node);
     }
+    const int mid = (leftmost + rightmost) / 2;
+    if (index <= mid) {
+      node.left_child = pointSet(node.left_child, leftmost, mid, index, value - node.add);
+    } else {
+      node.right_child = pointSet(node.right_child, mid + 1, rightmost, index, value - node.add);
+    }
+    pull(node, rightmost - leftmost + 1);
+    return newNode(node);
+  }
+
+  int pointSet(int root, int index, T value) {
+    return pointSet(root, 0, N - 1, index, value);
   }
 
-  T query(int left, int right) {
+  int rangeAdd(int k, int leftmost, int rightmost, int left, int right, T value) {
     if (left > rightmost || right < leftmost) {
-      // Disjoint.
-      return 0;
-    } else if (leftmost >= left && rightmost <= right) {
+      // Disjoint: share the old subtree.
+      return k;
+    }
+    Node node = nodes[k];
+    const int len = rightmost - leftmost + 1;
+    if (leftmost >= left && rightmost <= right) {
       // Fully contained within.
-
-      // We don't need to propagate since we are not going down to
-      // the children of this node.
-
-      return sum;
+      node.add += value;
+      node.sum += value * len;
+      node.minimum += value;
     } else {
       // Partially overlapping.
-      propagate();
-      return left_child->query(left, right) + right_child->query(left, right);
+      const int mid = (leftmost + rightmost) / 2;
+      node.left_child = rangeAdd(node.left_child, leftmost, mid, left, right, value);
+      node.right_child = rangeAdd(node.right_child, mid + 1, rightmost, left, right, value);
+      pull(node, len);
     }
+    return newNode(node);
   }
 
-  void rangeAdd(int left, int right, T value) {
-    if (left > rightmost || right < leftmost) {
-      // Disjoint: don't do anything.
-    } else if (leftmost >= left && rightmost <= right) {
-      // Fully contained within.
+  int rangeAdd(int root, int left, int right, T value) {
+    return rangeAdd(root, 0, N - 1, left, right, value);
+  }
 
-      // Propagation is necessary to make subtree nodes consistent but
-      // we're not going down to the subtree so no need to propagate.
+  int pointAdd(int root, int index, T value) {
+    return rangeAdd(root, 0, N - 1, index, index, value);
+  }
 
-      const int len = (rightmost - leftmost + 1);
-      sum += value * len;
-      // Set propagation value which signifies that subtree is out of sync.
-      prop += value;
-    } else {
-      // Partially overlapping.
-      // assert(left_child != nullptr && right_child != nullptr);
-      propagate();
-      left_child->rangeAdd(left, right, value);
-      right_child->rangeAdd(left, right, value);
-      sum = left_child->sum + right_child->sum;
+  T sum(int k, int leftmost, int rightmost, int left, int right) const {
+    if (left > rightmost || right < leftmost) return 0;
+    const Node& node = nodes[k];
+    if (leftmost >= left && rightmost <= right) return node.sum;
+    const int mid = (leftmost + rightmost) / 2;
+    const int overlap = min(right, rightmost) - max(left, leftmost) + 1;
+    return sum(node.left_child, leftmost, mid, left, right) +
+           sum(node.right_child, mid + 1, rightmost, left, right) +
+           node.add * overlap;
+  }
+
+  T sum(int root, int left, int right) const {
+    return sum(root, 0, N - 1, left, right);
+  }
+
+  T minimum(int k, int leftmost, int rightmost, int left, int right) const {
+    if (left > rightmost || right < leftmost) return numeric_limits<T>::max();
+    const Node& node = nodes[k];
+    if (leftmost >= left && rightmost <= right) return node.minimum;
+    const int mid = (leftmost + rightmost) / 2;
+    return min(minimum(node.left_child, leftmost, mid, left, right),
+               minimum(node.right_child, mid + 1, rightmost, left, right)) + node.add;
+  }
+
+  T minimum(int root, int left, int right) const {
+    return minimum(root, 0, N - 1, left, right);
+  }
+
+  // k-th smallest (0-indexed) in a range of an array a, with the tree
+  // used as a counter over compressed values:
+  //   roots[0] = build(vector<T>(num_values, 0))
+  //   roots[i + 1] = pointAdd(roots[i], rank(a[i]), 1)
+  // The k-th smallest of a[l..r] has rank kth(roots[l], roots[r + 1], k).
+  // Only valid for versions built with pointAdd.
+  int kth(int root_before, int root_after, T k) const {
+    int leftmost = 0;
+    int rightmost = N - 1;
+    while (leftmost != rightmost) {
+      const int mid = (leftmost + rightmost) / 2;
+      const Node& before = nodes[root_before];
+      const Node& after = nodes[root_after];
+      const T count_left = nodes[after.left_child].sum - nodes[before.left_child].sum;
+      if (k < count_left) {
+        root_before = before.left_child;
+        root_after = after.left_child;
+        rightmost = mid;
+      } else {
+        k -= count_left;
+        root_before = before.right_child;
+        root_after = after.right_child;
+        leftmost = mid + 1;
+      }
     }
+    return leftmost;
   }
 };
 
-// Supports rangeMin using lazy propagation.
+// Dynamic (sparse) segment tree supporting setTo, rangeAdd and sum over a
+// huge coordinate range [leftmost, rightmost], e.g. [0, 1e18].
+// Nodes are only created when an update or query needs to go below
+// them, so memory is O(Q log C) instead of O(C). Nodes live in one pool
+// and refer to their children by index (-1 = not created yet).
+// Update, query: O(log C)
 template <class T>
-struct SegTree {
-  const int INFTY = 1e9;
-
-  int leftmost;
-  int rightmost;
-  shared_ptr<SegTree> left_child = nullptr;
-  shared_ptr<SegTree> right_child = nullptr;
-  T minimum;
-  // Propagation value that hasn't been propagated to its children.
-  // If prop is non-zero tt means that the subtree is out of sync with
-  // its root (root = this node).
-  T prop;
-
-  SegTree(int leftmost, int rightmost) : leftmost(leftmost), rightmost(rightmost), minimum(0), prop(0) {
-    if (leftmost != rightmost) {
-      const int mid = (leftmost + rightmost) / 2;
-      left_child = make_shared<SegTree<T>>(leftmost, mid);
-      right_child = make_shared<SegTree<T>>(mid + 1, rightmost);
-    }
+struct DynamicSegTree {
+  struct Node {
+    int left_child;
+    int right_child;
+    T sum;
+    // { is_set_to, value }, same meaning as in SetAddSum.
+    pair<bool, T> prop;
+  };
+
+  int64_t leftmost;
+  int64_t rightmost;
+  // Value of every element before any update.
+  T initial;
+  vector<Node> nodes;
+
+  // capacity: expected number of nodes, e.g. Q * 4 * log(C).
+  DynamicSegTree(int64_t leftmost, int64_t rightmost, T initial = 0, int capacity = 0) :
+    leftmost(leftmost), rightmost(rightmost), initial(initial) {
+    nodes.reserve(capacity);
+    newNode(leftmost, rightmost);
   }
 
-  // Propagate to the subtree.
-  void propagate() {
-    // assert(left_child != nullptr && right_child != nullptr);
-    if (prop != 0) {
-      left_child->minimum += prop;
-      left_child->prop += prop;
+  int newNode(int64_t lo, int64_t hi) {
+    nodes.push_back({ -1, -1, initial * T(hi - lo + 1), { false, 0 } });
+    return nodes.size() - 1;
+  }
 
-      right_child->minimum += prop;
-      right_child->prop += prop;
+  void applyTag(int k, int64_t len, const pair<bool, T>& tag) {
+    Node& node = nodes[k];
+    if (tag.first) {
+      // setTo overrides whatever was there before.
+      node.sum = tag.second * T(len);
+      node.prop = tag;
+    } else {
+      // Range add stays range add and setTo stays setTo.
+      node.sum += tag.second * T(len);
+      node.prop.second += tag.second;
+    }
+  }
 
-      prop = 0;
+  // Create the children if needed and propagate to them.
+  void propagate(int k, int64_t lo, int64_t hi) {
+    const int64_t mid = lo + (hi - lo) / 2;
+    // Note: newNode can reallocate the pool, so no references are kept.
+    if (nodes[k].left_child == -1) {
+      const int child = newNode(lo, mid);
+      nodes[k].left_child = child;
+    }
+    if (nodes[k].right_child == -1) {
+      const int child = newNode(mid + 1, hi);
+      nodes[k].right_child = child;
+    }
+    const pair<bool, T> prop = nodes[k].prop;
+    if (prop.first || prop.second != 0) {
+      applyTag(nodes[k].left_child, mid - lo + 1, prop);
+      applyTag(nodes[k].right_child, hi - mid, prop);
+      nodes[k].prop = { false, 0 };
     }
   }
 
-  T query(int left, int right) {
-    if (left > rightmost || right < leftmost) {
-      // Disjoint.
-      return INFTY;
-    } else if (leftmost >= left && rightmost <= right) {
+  void update(int k, int64_t lo, int64_t hi, int64_t left, int64_t right, const pair<bool, T>& tag) {
+    if (left > hi || right < lo) {
+      // Disjoint: don't do anything.
+    } else if (lo >= left && hi <= right) {
       // Fully contained within.
-
-      // We don't need to propagate since we are not going down to
-      // the children of this node.
-
-      return minimum;
+      applyTag(k, hi - lo + 1, tag);
     } else {
       // Partially overlapping.
-      propagate();
-      return min(left_child->query(left, right), right_child->query(left, right));
+      propagate(k, lo, hi);
+      const int64_t mid = lo + (hi - lo) / 2;
+      const int left_child = nodes[k].left_child;
+      const int right_child = nodes[k].right_child;
+      update(left_child, lo, mid, left, right, tag);
+      update(right_child, mid + 1, hi, left, right, tag);
+      nodes[k].sum = nodes[left_child].sum + nodes[right_child].sum;
     }
   }
 
-  void add(int left, int right, T value) {
-    if (left > rightmost || right < leftmost) {
-      // Disjoint: don't do anything.
-    } else if (leftmost >= left && rightmost <= right) {
+  T query(int k, int64_t lo, int64_t hi, int64_t left, int64_t right) {
+    if (left > hi || right < lo) {
+      // Disjoint.
+      return 0;
+    } else if (lo >= left && hi <= right) {
       // Fully contained within.
-
-      // Propagation is necessary to make subtree nodes consistent but
-      // we're not going down to the subtree so no need to propagate.
-
-      minimum += value;
-      // Set propagation value which signifies that subtree is out of sync.
-      prop += value;
+      return nodes[k].sum;
     } else {
       // Partially overlapping.
-      assert(left_child != nullptr && right_child != nullptr);
-      propagate();
-      left_child->add(left, right, value);
-      right_child->add(left, right, value);
-      minimum = min(left_child->minimum, right_child->minimum);
+      propagate(k, lo, hi);
+      const int64_t mid = lo + (hi - lo) / 2;
+      const int left_child = nodes[k].left_child;
+      const int right_child = nodes[k].right_child;
+      return query(left_child, lo, mid, left, right) +
+             query(right_child, mid + 1, hi, left, right);
     }
   }
+
+  void rangeAdd(int64_t left, int64_t right, T value) {
+    update(0, leftmost, rightmost, left, right, { false, value });
+  }
+
+  void setTo(int64_t left, int64_t right, T value) {
+    update(0, leftmost, rightmost, left, right, { true, value });
+  }
+
+  T query(int64_t left, int64_t right) {
+    return query(0, leftmost, rightmost, left, right);
+  }
 };
 
-// Supports both setTo and rangeAdd
+// Segment Tree Beats (Ji Ruyi's technique).
+// Supports range chmin (a[i] = min(a[i], x)), range chmax, rangeAdd and
+// sum/max/min queries.
+// chmin only updates a node lazily if x is between its largest and second
+// largest value: the node's maxima just move to x. Otherwise it goes down
+// into the children ("beats" the tag condition), which amortizes out.
+// Build: O(N)
+// rangeAdd, query: O(log N)
+// chmin, chmax: amortized O(log^2 N)
 template <class T>
-struct SegTree {
-  int leftmost;
-  int rightmost;
-  shared_ptr<SegTree> left_child;
-  shared_ptr<SegTree> right_child;
-  T sum;
-
-  // Propagation value that hasn't been propagated to its children.
-  // If prop is non-zero this means that "sum" variable of this node
-  // contains a different value than the sum of the left_child and
-  // right_child sum. It means that the subtree is out of sync with
-  // its root (root = this node).
-  
-  // { is_set_to, value }
-  // where value is "setTo" value when is_set_to = true
-  // and value is "rangeAdd" value when is_set_to = false
-  pair<bool, T> prop;
-
-  SegTree(int leftmost, int rightmost, const vector<T>& elements) {
-    this->leftmost = leftmost;
-    this->rightmost = rightmost;
-    prop = { false, 0 };
+struct SegTreeBeats {
+  const T NEG_INFTY = numeric_limits<T>::lowest();
+  const T INFTY = numeric_limits<T>::max();
+
+  struct Node {
+    T sum;
+    T max1, max2;  // Largest and strictly second largest value.
+    int max_count;  // Number of elements equal to max1.
+    T min1, min2;  // Smallest and strictly second smallest value.
+    int min_count;  // Number of elements equal to min1.
+    T add;  // rangeAdd value that hasn't been propagated yet.
+  };
+
+  int N;
+  vector<Node> tree;  // In "heap format", root at 1.
+
+  SegTreeBeats(const vector<T>& elements) : N(elements.size()), tree(4 * max(N, 1)) {
+    if (N > 0) build(1, 0, N - 1, elements);
+  }
+
+  void build(int k, int leftmost, int rightmost, const vector<T>& elements) {
     if (leftmost == rightmost) {
-      sum = elements[leftmost];
-    } else {
-      const int mid = (leftmost + rightmost) / 2;
-      left_child = make_shared<SegTree<T>>(leftmost, mid, elements);
-      right_child = make_shared<SegTree<T>>(mid + 1, rightmost, elements);
-      sum = left_child->sum + right_child->sum;
+      const T value = elements[leftmost];
+      tree[k] = { value, value, NEG_INFTY, 1, value, INFTY, 1, 0 };
+      return;
     }
+    const int mid = (leftmost + rightmost) / 2;
+    build(2 * k, leftmost, mid, elements);
+    build(2 * k + 1, mid + 1, rightmost, elements);
+    tree[k].add = 0;
+    pull(k);
   }
 
-  // Propagate to the subtree.
-  void propagate() {
-    // assert(left_child != nullptr && right_child != nullptr);
-    const int len_left_child = (left_child->rightmost - left_child->leftmost + 1);
-    const int len_right_child = (right_child->rightmost - right_child->leftmost + 1);
-
-    if (prop.first) {
-      // setTo
-      left_child->sum = prop.second * len_left_child;
-      left_child->prop = prop;
-
-      right_child->sum = prop.second * len_right_child;
-      right_child->prop = prop;      
+  void pull(int k) {
+    Node& node = tree[k];
+    const Node& left = tree[2 * k];
+    const Node& right = tree[2 * k + 1];
+    node.sum = left.sum + right.sum;
+
+    if (left.max1 == right.max1) {
+      node.max1 = left.max1;
+      node.max2 = max(left.max2, right.max2);
+      node.max_count = left.max_count + right.max_count;
+    } else if (left.max1 > right.max1) {
+      node.max1 = left.max1;
+      node.max2 = max(left.max2, right.max1);
+      node.max_count = left.max_count;
     } else {
-      // rangeAdd
-      left_child->sum += prop.second * len_left_child;
-      left_child->prop.second += prop.second;
+      node.max1 = right.max1;
+      node.max2 = max(left.max1, right.max2);
+      node.max_count = right.max_count;
+    }
 
-      right_child->sum += prop.second * len_right_child;
-      right_child->prop.second += prop.second;      
+    if (left.min1 == right.min1) {
+      node.min1 = left.min1;
+      node.min2 = min(left.min2, right.min2);
+      node.min_count = left.min_count + right.min_count;
+    } else if (left.min1 < right.min1) {
+      node.min1 = left.min1;
+      node.min2 = min(left.min2, right.min1);
+      node.min_count = left.min_count;
+    } else {
+      node.min1 = right.min1;
+      node.min2 = min(left.min1, right.min2);
+      node.min_count = right.min_count;
     }
-    // Reset prop because we're done propagating.
-    prop = { false, 0 };
   }
 
-  T query(int left, int right) {
-    if (left > rightmost || right < leftmost) {
-      // Disjoint.
-      return 0;
-    } else if (leftmost >= left && rightmost <= right) {
-      // Fully contained within.
-
-      // We don't need to propagate since we are not going down to
-      // the children of this node.
+  void applyAdd(int k, int len, T value) {
+    Node& node = tree[k];
+    node.sum += value * len;
+    node.max1 += value;
+    if (node.max2 != NEG_INFTY) node.max2 += value;
+    node.min1 += value;
+    if (node.min2 != INFTY) node.min2 += value;
+    node.add += value;
+  }
 
-      return sum;
-    } else {
-      // Partially overlapping.
-      propagate();
-      return left_child->query(left, right) + right_child->query(left, right);
+  // Requires max2 < x < max1.
+  void applyChmin(int k, T x) {
+    Node& node = tree[k];
+    node.sum += (x - node.max1) * node.max_count;
+    if (node.max1 == node.min1) {
+      // All values are equal.
+      node.min1 = x;
+    } else if (node.max1 == node.min2) {
+      // Only two distinct values.
+      node.min2 = x;
     }
+    node.max1 = x;
   }
 
-  void rangeAdd(int left, int right, T value) {
-    if (left > rightmost || right < leftmost) {
-      // Disjoint: don't do anything.
-    } else if (leftmost >= left && rightmost <= right) {
-      // Fully contained within.
+  // Requires min1 < x < min2.
+  void applyChmax(int k, T x) {
+    Node& node = tree[k];
+    node.sum += (x - node.min1) * node.min_count;
+    if (node.min1 == node.max1) {
+      node.max1 = x;
+    } else if (node.min1 == node.max2) {
+      node.max2 = x;
+    }
+    node.min1 = x;
+  }
 
-      // Propagation is necessary to make subtree nodes consistent but
-      // we're not going down to the subtree so no need to propagate.
+  // Propagate to the subtree.
+  void propagate(int k, int leftmost, int rightmost) {
+    const int mid = (leftmost + rightmost) / 2;
+    if (tree[k].add != 0) {
+      applyAdd(2 * k, mid - leftmost + 1, tree[k].add);
+      applyAdd(2 * k + 1, rightmost - mid, tree[k].add);
+      tree[k].add = 0;
+    }
+    // Pending chmin/chmax are implied by the node's own max1/min1.
+    for (int child = 2 * k; child <= 2 * k + 1; ++child) {
+      if (tree[child].max1 > tree[k].max1) applyChmin(child, tree[k].max1);
+      if (tree[child].min1 < tree[k].min1) applyChmax(child, tree[k].min1);
+    }
+  }
 
-      const int len = (rightmost - leftmost + 1);
-      sum += value * len;
-      // Set propagation value which signifies that subtree is out of sync.
+  void chmin(int k, int leftmost, int rightmost, int left, int right, T x) {
+    if (left > rightmost || right < leftmost || tree[k].max1 <= x) {
+      // Disjoint or nothing to do.
+      return;
+    }
+    if (leftmost >= left && rightmost <= right && tree[k].max2 < x) {
+      applyChmin(k, x);
+      return;
+    }
+    propagate(k, leftmost, rightmost);
+    const int mid = (leftmost + rightmost) / 2;
+    chmin(2 * k, leftmost, mid, left, right, x);
+    chmin(2 * k + 1, mid + 1, rightmost, left, right, x);
+    pull(k);
+  }
 
-      // Range add stays range add but with higher value
-      // setTo stays setTo but with higher value.
-      prop.second += value;
-    } else {
-      // Partially overlapping.
-      // assert(left_child != nullptr && right_child != nullptr);
-      propagate();
-      left_child->rangeAdd(left, right, value);
-      right_child->rangeAdd(left, right, value);
-      sum = left_child->sum + right_child->sum;
+  void chmax(int k, int leftmost, int rightmost, int left, int right, T x) {
+    if (left > rightmost || right < leftmost || tree[k].min1 >= x) {
+      return;
+    }
+    if (leftmost >= left && rightmost <= right && tree[k].min2 > x) {
+      applyChmax(k, x);
+      return;
     }
+    propagate(k, leftmost, rightmost);
+    const int mid = (leftmost + rightmost) / 2;
+    chmax(2 * k, leftmost, mid, left, right, x);
+    chmax(2 * k + 1, mid + 1, rightmost, left, right, x);
+    pull(k);
   }
 
-  void setTo(int left, int right, T value) {
+  void rangeAdd(int k, int leftmost, int rightmost, int left, int right, T value) {
     if (left > rightmost || right < leftmost) {
-      // Disjoint: don't do anything.
-    } else if (leftmost >= left && rightmost <= right) {
-      // Fully contained within.
+      return;
+    }
+    if (leftmost >= left && rightmost <= right) {
+      applyAdd(k, rightmost - leftmost + 1, value);
+      return;
+    }
+    propagate(k, leftmost, rightmost);
+    const int mid = (leftmost + rightmost) / 2;
+    rangeAdd(2 * k, leftmost, mid, left, right, value);
+    rangeAdd(2 * k + 1, mid + 1, rightmost, left, right, value);
+    pull(k);
+  }
 
-      // No need to propagate.
-      const int len = (rightmost - leftmost + 1);
-      sum = value * len;
-      // Lazy prop becomes a "setTo". Whatever was there before gets
-      // overridden.
-      prop = { true, value };
-    } else {
-      // Partially overlapping.
-      // assert(left_child != nullptr && right_child != nullptr);
-      propagate();
-      left_child->setTo(left, right, value);
-      right_child->setTo(left, right, value);
-      sum = left_child->sum + right_child->sum;
+  // Returns the node summarizing [left, right], only sum/max1/min1 are valid.
+  Node query(int k, int leftmost, int rightmost, int left, int right) {
+    if (leftmost >= left && rightmost <= right) {
+      return tree[k];
     }
+    propagate(k, leftmost, rightmost);
+    const int mid = (leftmost + rightmost) / 2;
+    if (right <= mid) return query(2 * k, leftmost, mid, left, right);
+    if (left > mid) return query(2 * k + 1, mid + 1, rightmost, left, right);
+    Node a = query(2 * k, leftmost, mid, left, right);
+    const Node b = query(2 * k + 1, mid + 1, rightmost, left, right);
+    a.sum += b.sum;
+    a.max1 = max(a.max1, b.max1);
+    a.min1 = min(a.min1, b.min1);
+    return a;
+  }
+
+  void chmin(int left, int right, T x) {
+    chmin(1, 0, N - 1, left, right, x);
+  }
+
+  void chmax(int left, int right, T x) {
+    chmax(1, 0, N - 1, left, right, x);
+  }
+
+  void rangeAdd(int left, int right, T value) {
+    rangeAdd(1, 0, N - 1, left, right, value);
+  }
+
+  T sum(int left, int right) {
+    return query(1, 0, N - 1, left, right).sum;
+  }
+
+  T maximum(int left, int right) {
+    return query(1, 0, N - 1, left, right).max1;
+  }
+
+  T minimum(int left, int right) {
+    return query(1, 0, N - 1, left, right).min1;
   }
 };
@@ -1,20 +1,27 @@
+// Requires CSRGraph (csr_graph.cpp).
 struct TwoSat {
   int N;
-  vector<vector<int>> gr;
+  CSRGraph<> gr;
   vector<int> values; // 0 = false, 1 = true
 
   TwoSat(int n = 0) : N(n), gr(2*n) {}
 
+  // From an implication graph: vertex 2*i + value is "variable i == value",
+  // an edge a -> b means "a implies b".
+  TwoSat(CSRGraph<> g) : N(g.N / 2), gr(move(g)) {
+    assert(gr.N % 2 == 0);
+  }
+
   int add_var() { // (optional)
-    gr.emplace_back();
-    gr.emplace_back();
+    gr.addVertex();
+    gr.addVertex();
     return N++;
   }
 
   void add_clause(int aind, bool aval, int bind, bool bval) {
     int a = 2*aind + aval, b = 2*bind + bval;
-    gr[a^1].push_back(b);
-    gr[b^1].push_back(a);
+    gr.addEdge(a^1, b);
+    gr.addEdge(b^1, a);
   }
 
   void set_value(int index, bool value) {
@@ -39,27 +46,48 @@ struct TwoSat {
     add_clause(cur, !val, li[1], !val);
   }
 
-  vector<int> val, comp, z; int time = 0;
-  int dfs(int i) {
-    int low = val[i] = ++time, x; z.push_back(i);
-    for (int e : gr[i]) {
-      if (!comp[e]) {
-        low = min(low, val[e] ? val[e] : dfs(e));
+  vector<int> val, comp, z, low; int time = 0;
+  // Explicit DFS stack of { vertex, next edge }.
+  vector<pair<int, int>> st;
+
+  void enter(int i) {
+    low[i] = val[i] = ++time; z.push_back(i);
+    st.push_back({ i, gr.offsets[i] });
+  }
+
+  // Iterative Tarjan, same visiting order as the recursive version.
+  void dfs(int start) {
+    enter(start);
+    while (!st.empty()) {
+      int i = st.back().first, &k = st.back().second, x;
+      if (k < gr.offsets[i + 1]) {
+        const int e = gr.targets[k++];
+        if (!comp[e]) {
+          if (val[e]) low[i] = min(low[i], val[e]);
+          else enter(e);
+        }
+        continue;
+      }
+      st.pop_back();
+      ++time;
+      if (low[i] == val[i]) do {
+        x = z.back(); z.pop_back();
+        comp[x] = time;
+        if (values[x>>1] == -1)
+          values[x>>1] = x&1;
+      } while (x != i);
+      val[i] = low[i];
+      if (!st.empty()) {
+        int p = st.back().first;
+        low[p] = min(low[p], val[i]);
       }
     }
-    ++time;
-    if (low == val[i]) do {
-      x = z.back(); z.pop_back();
-      comp[x] = time;
-      if (values[x>>1] == -1)
-        values[x>>1] = x&1;
-    } while (x != i);
-    return val[i] = low;
   }
 
   bool solve() {
+    gr.build();
     values.assign(N, -1);
-    val.assign(2*N, 0); comp = val;
+    val.assign(2*N, 0); comp = val; low = val;
     for (int i = 0; i < 2 * N; ++i) {
       if (!comp[i]) {
         dfs(i);
@@ -0,0 +1,38 @@
+// Per-vertex DFS state, one byte per vertex.
+// WHITE: not visited, GREY: on the DFS stack, BLACK: done.
+// reset() makes every vertex WHITE again in O(1): the bytes are tagged
+// with an epoch and anything from an older epoch reads as WHITE. Only
+// every 126 resets the array is actually cleared.
+struct VertexState {
+  enum Color : uint8_t { WHITE, GREY, BLACK };
+
+  vector<uint8_t> mark;
+  // GREY is stored as epoch, BLACK as epoch + 1.
+  uint8_t epoch;
+
+  VertexState(int N = 0) : mark(N, 0), epoch(1) {}
+
+  Color get(int u) const {
+    const uint8_t m = mark[u];
+    if (m == epoch) return GREY;
+    if (m == epoch + 1) return BLACK;
+    return WHITE;
+  }
+
+  void set(int u, Color color) {
+    mark[u] = (color == WHITE) ? 0 : epoch + color - 1;
+  }
+
+  bool visited(int u) const {
+    return get(u) != WHITE;
+  }
+
+  void reset() {
+    if (epoch >= 253) {
+      fill(mark.begin(), mark.end(), 0);
+      epoch = 1;
+    } else {
+      epoch += 2;
+    }
+  }
+};